@@ -1,6 +1,579 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
-int main(){
-    std::cout << "Hello World!\n";
+#include "batch.h"
+#include "bundle.h"
+#include "compile.h"
+#include "daemon.h"
+#include "decompress.h"
+#include "encoding.h"
+#include "lines.h"
+#include "mapped_file.h"
+#include "profile.h"
+#include "rules.h"
+#include "uring_scan.h"
+#include "walk.h"
+
+namespace {
+
+struct Options {
+    std::vector<std::string> patterns;
+    std::string rules_file;
+    std::string bundle_file;
+    std::string daemon_socket;
+    std::string connect_socket;
+    std::string profile_file;
+    bool anchored = false;
+    bool uring = false;
+    bool decompress = false;
+    bool lines = false;
+    bool count = false;
+    bool invert = false;
+    bool skip_binary = false;
+    bool recursive = false;
+    size_t record_size = 0;
+    fsa::WalkOptions walk;
+    std::vector<std::string> files;
+};
+
+int usage(){
+    std::cerr <<
+        "usage: Regex [options] PATTERN [FILE...]\n"
+        "       Regex [options] (-e PATTERN | -f RULES | -b BUNDLE)... [FILE...]\n"
+        "       Regex --daemon SOCKET (-e PATTERN | -f RULES | -b BUNDLE)...\n"
+        "       Regex --connect SOCKET [FILE...]\n"
+        "       Regex --record-profile OUT (-e PATTERN | -f RULES)... [FILE...]\n"
+        "Prints FILE:IDS for every input matching a pattern, where IDS are the\n"
+        "matching pattern numbers in rule order. Reads standard input without\n"
+        "FILEs. Exits 0 on a match, 1 on none, 2 on errors.\n"
+        "  -e PATTERN       add a pattern\n"
+        "  -f RULES         add the patterns of a rule file, one per line\n"
+        "  -b BUNDLE        use a bundle compiled by regexc\n"
+        "  --anchored       match only at the start of each input\n"
+        "  --lines          print matching lines as FILE:LINE instead of pattern IDs\n"
+        "  -c               print FILE:COUNT of matching lines (implies --lines)\n"
+        "  -v               select lines without a match (implies --lines)\n"
+        "  --records SIZE   treat inputs as packed SIZE-byte records and print\n"
+        "                   FILE:INDEX of matching ones (-c and -v apply); a\n"
+        "                   trailing partial record is ignored\n"
+        "  -r               search directories recursively (\".\" without FILEs),\n"
+        "                   honoring .gitignore files\n"
+        "  --ignore GLOB    with -r, skip paths matching a .gitignore-style rule\n"
+        "  --no-ignore      with -r, do not read .gitignore files\n"
+        "  -I               skip binary inputs (a NUL byte in the first 64 KiB)\n"
+        "  -z               decompress gzip and zstd FILEs while scanning them\n"
+        "  --uring          read FILEs through io_uring, scanning while reading\n"
+        "  --daemon SOCKET  load the rules once and serve matches on SOCKET\n"
+        "  --connect SOCKET ask a running daemon instead of compiling; every\n"
+        "                   other argument is a FILE\n"
+        "  --record-profile OUT\n"
+        "                   instead of printing matches, count the transitions\n"
+        "                   each whole input takes and save them to OUT for\n"
+        "                   regexc --profile (same rules and --anchored)\n";
+    return 2;
+}
+
+// The -e patterns followed by those of the -f rule file.
+std::vector<std::string> load_patterns(const Options& options){
+    std::vector<std::string> patterns = options.patterns;
+    if(!options.rules_file.empty()){
+        std::ifstream in(options.rules_file);
+        if(!in) throw std::runtime_error("cannot open " + options.rules_file);
+        std::vector<std::string> more = fsa::read_rules(in);
+        patterns.insert(patterns.end(), more.begin(), more.end());
+    }
+    return patterns;
+}
+
+// Compiled rules ready to scan: a mapped bundle, or one built in memory.
+class Rules {
+public:
+    explicit Rules(const Options& options){
+        if(!options.bundle_file.empty()){
+            mapped_.emplace(options.bundle_file);
+            view_ = std::make_unique<fsa::BundleView>(mapped_->data(), mapped_->size());
+            return;
+        }
+        fsa::CompileOptions compile_options;
+        compile_options.anchored = options.anchored;
+        words_ = fsa::build_bundle(fsa::compile(load_patterns(options), compile_options));
+        view_ = std::make_unique<fsa::BundleView>(words_.data(), words_.size() * sizeof(uint32_t));
+    }
+
+    const fsa::BundleView& view() const { return *view_; }
+
+private:
+    std::optional<fsa::MappedFile> mapped_;
+    std::vector<uint32_t> words_;
+    std::unique_ptr<fsa::BundleView> view_;
+};
+
+const char* STDIN_NAME = "(standard input)";
+
+std::string read_stdin(){
+    return std::string(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+}
+
+// Prints one result line; returns whether it was a match.
+bool report(const std::string& name, const std::vector<fsa::PatternId>& found){
+    if(found.empty()) return false;
+    std::cout << name << ":";
+    for(size_t i = 0; i < found.size(); i++) std::cout << (i ? "," : "") << found[i];
+    std::cout << "\n";
+    return true;
+}
+
+bool is_binary(std::string_view text){
+    return fsa::detect_encoding(text.substr(0, fsa::ENCODING_PROBE)) == fsa::Encoding::Binary;
+}
+
+int scan_files(const fsa::BundleView& rules, const Options& options){
+    bool matched = false;
+    bool failed = false;
+    if(options.files.empty()){
+        std::string text = read_stdin();
+        if(options.skip_binary && is_binary(text)) return 1;
+        return report(STDIN_NAME, rules.match_set(text)) ? 0 : 1;
+    }
+    for(const std::string& file : options.files){
+        try{
+            if(options.decompress){
+                fsa::DecompressedReader reader(file);
+                fsa::StreamMatcher<fsa::BundleView> matcher(rules);
+                std::string_view chunk = reader.next();
+                if(options.skip_binary && is_binary(chunk)) continue;
+                for(; !chunk.empty() && !matcher.done(); chunk = reader.next()) matcher.feed(chunk);
+                matched |= report(file, matcher.matches());
+                continue;
+            }
+            fsa::MappedFile input(file);
+            if(options.skip_binary && is_binary(input.view())) continue;
+            matched |= report(file, rules.match_set(input.view()));
+        }catch(const std::exception& e){
+            std::cerr << "Regex: " << e.what() << "\n";
+            failed = true;
+        }
+    }
+    return failed ? 2 : matched ? 0 : 1;
+}
+
+// Line mode: prints selected lines, or their count per input. Text comes
+// in blocks of whole lines (the last may lack its newline), so a stream
+// can be fed as it arrives. Lines of binary inputs are not printed, only
+// whether there were any.
+class LineSelector {
+public:
+    LineSelector(const fsa::BundleView& rules, const Options& options, const std::string& name, bool binary)
+        : rules_(rules), options_(options), name_(name), binary_(binary){}
+
+    void feed(std::string_view text){
+        auto ignore = [](size_t, size_t){};
+        auto print = [&](size_t begin, size_t end){
+            std::cout << name_ << ":";
+            std::cout.write(text.data() + begin, static_cast<std::streamsize>(end - begin)) << "\n";
+        };
+        if(options_.count){
+            size_t matched = fsa::scan_lines(rules_, text, ignore);
+            selected_ += options_.invert ? fsa::count_lines(text) - matched : matched;
+        }else if(binary_){
+            selected_ += options_.invert ? fsa::scan_lines_inverted(rules_, text, ignore) : fsa::scan_lines(rules_, text, ignore);
+        }else{
+            selected_ += options_.invert ? fsa::scan_lines_inverted(rules_, text, print) : fsa::scan_lines(rules_, text, print);
+        }
+    }
+
+    // Prints the count or the binary note; returns whether any line was
+    // selected.
+    bool finish(){
+        if(options_.count) std::cout << name_ << ":" << selected_ << "\n";
+        else if(binary_ && selected_) std::cout << name_ << ": binary file matches\n";
+        return selected_ > 0;
+    }
+
+private:
+    const fsa::BundleView& rules_;
+    const Options& options_;
+    const std::string& name_;
+    bool binary_;
+    size_t selected_ = 0;
+};
+
+bool report_lines(const fsa::BundleView& rules, const Options& options, const std::string& name, std::string_view text){
+    bool binary = is_binary(text);
+    if(binary && options.skip_binary) return false;
+    LineSelector selector(rules, options, name, binary);
+    selector.feed(text);
+    return selector.finish();
+}
+
+// Line mode over a decompressed file: whole lines are scanned as chunks
+// arrive, and a line cut by a chunk boundary is carried into the next.
+bool report_lines_decompressed(const fsa::BundleView& rules, const Options& options, const std::string& file){
+    fsa::DecompressedReader reader(file);
+    std::string_view chunk = reader.next();
+    bool binary = is_binary(chunk);
+    if(binary && options.skip_binary) return false;
+    LineSelector selector(rules, options, file, binary);
+    std::string carry;
+    for(; !chunk.empty(); chunk = reader.next()){
+        size_t last = chunk.rfind('\n');
+        if(last == std::string_view::npos){
+            carry.append(chunk);
+            continue;
+        }
+        size_t first = 0;
+        if(!carry.empty()){
+            first = chunk.find('\n') + 1;
+            carry.append(chunk.substr(0, first));
+            selector.feed(carry);
+        }
+        if(first <= last) selector.feed(chunk.substr(first, last + 1 - first));
+        carry.assign(chunk.substr(last + 1));
+    }
+    if(!carry.empty()) selector.feed(carry);
+    return selector.finish();
+}
+
+int scan_files_by_line(const fsa::BundleView& rules, const Options& options){
+    if(options.files.empty()) return report_lines(rules, options, STDIN_NAME, read_stdin()) ? 0 : 1;
+    bool selected = false;
+    bool failed = false;
+    for(const std::string& file : options.files){
+        try{
+            if(options.decompress){
+                selected |= report_lines_decompressed(rules, options, file);
+                continue;
+            }
+            fsa::MappedFile input(file);
+            selected |= report_lines(rules, options, file, input.view());
+        }catch(const std::exception& e){
+            std::cerr << "Regex: " << e.what() << "\n";
+            failed = true;
+        }
+    }
+    return failed ? 2 : selected ? 0 : 1;
+}
+
+// Record mode: prints the indexes of selected records, or their count per
+// input. Like LineSelector, it takes the input in blocks of whole records.
+class RecordSelector {
+public:
+    RecordSelector(const fsa::BundleView& rules, const Options& options, const std::string& name)
+        : rules_(rules), options_(options), name_(name){}
+
+    void feed(std::string_view text){
+        size_t records = text.size() / options_.record_size;
+        selection_.resize((records + 7) / 8);
+        fsa::ColumnFilter filter;
+        filter.whole_value = false;
+        fsa::filter_records(rules_, reinterpret_cast<const uint8_t*>(text.data()), options_.record_size, records,
+                            selection_.data(), filter);
+        for(size_t i = 0; i < records; i++){
+            if(static_cast<bool>(selection_[i >> 3] >> (i & 7) & 1) == options_.invert) continue;
+            selected_++;
+            if(!options_.count) std::cout << name_ << ":" << first_ + i << "\n";
+        }
+        first_ += records;
+    }
+
+    // Prints the count; returns whether any record was selected.
+    bool finish(){
+        if(options_.count) std::cout << name_ << ":" << selected_ << "\n";
+        return selected_ > 0;
+    }
+
+private:
+    const fsa::BundleView& rules_;
+    const Options& options_;
+    const std::string& name_;
+    std::vector<uint8_t> selection_;
+    size_t first_ = 0;   // index of the next record fed
+    size_t selected_ = 0;
+};
+
+bool report_records(const fsa::BundleView& rules, const Options& options, const std::string& name, std::string_view text){
+    RecordSelector selector(rules, options, name);
+    selector.feed(text);
+    return selector.finish();
+}
+
+// Record mode over a decompressed file, carrying a record cut by a chunk
+// boundary into the next chunk.
+bool report_records_decompressed(const fsa::BundleView& rules, const Options& options, const std::string& file){
+    fsa::DecompressedReader reader(file);
+    RecordSelector selector(rules, options, file);
+    const size_t size = options.record_size;
+    std::string carry;
+    for(std::string_view chunk = reader.next(); !chunk.empty(); chunk = reader.next()){
+        if(!carry.empty()){
+            size_t take = std::min(size - carry.size(), chunk.size());
+            carry.append(chunk.substr(0, take));
+            chunk.remove_prefix(take);
+            if(carry.size() < size) continue;
+            selector.feed(carry);
+            carry.clear();
+        }
+        size_t whole = chunk.size() / size * size;
+        selector.feed(chunk.substr(0, whole));
+        carry.assign(chunk.substr(whole));
+    }
+    return selector.finish();
+}
+
+int scan_files_by_record(const fsa::BundleView& rules, const Options& options){
+    if(options.files.empty()) return report_records(rules, options, STDIN_NAME, read_stdin()) ? 0 : 1;
+    bool selected = false;
+    bool failed = false;
+    for(const std::string& file : options.files){
+        try{
+            if(options.decompress){
+                selected |= report_records_decompressed(rules, options, file);
+                continue;
+            }
+            fsa::MappedFile input(file);
+            selected |= report_records(rules, options, file, input.view());
+        }catch(const std::exception& e){
+            std::cerr << "Regex: " << e.what() << "\n";
+            failed = true;
+        }
+    }
+    return failed ? 2 : selected ? 0 : 1;
+}
+
+// Falls back to scan_files() when io_uring is unavailable.
+int scan_files_ring(const fsa::BundleView& rules, const Options& options){
+    const std::vector<std::string>& files = options.files;
+    if(options.files.empty()) return scan_files(rules, options);
+    std::vector<fsa::FileMatches> results;
+    try{
+        results = fsa::scan_files_uring(rules, files);
+    }catch(const std::system_error& e){
+        std::cerr << "Regex: io_uring unavailable (" << e.what() << "), using mapped reads\n";
+        return scan_files(rules, options);
+    }
+    bool matched = false;
+    bool failed = false;
+    for(size_t i = 0; i < files.size(); i++){
+        if(results[i].error){
+            std::cerr << "Regex: " << files[i] << ": " << std::strerror(results[i].error) << "\n";
+            failed = true;
+        }else{
+            matched |= report(files[i], results[i].matches);
+        }
+    }
+    return failed ? 2 : matched ? 0 : 1;
+}
+
+// Scans the inputs in the mode the options ask for.
+int scan(const fsa::BundleView& rules, const Options& options){
+    bool ring = options.uring && !options.record_size && !options.lines && !options.decompress && !options.skip_binary;
+    if(options.uring && !ring){
+        // The ring only serves whole-file matching; warn like the
+        // io_uring fallback instead of dropping the flag silently.
+        std::cerr << "Regex: --uring does not apply with --lines, -c, -v, --records, -z or -I, using mapped reads\n";
+    }
+    if(options.record_size) return scan_files_by_record(rules, options);
+    if(options.lines) return scan_files_by_line(rules, options);
+    if(ring) return scan_files_ring(rules, options);
+    return scan_files(rules, options);
+}
+
+// Training mode: records a profile of the DFA regexc builds from the same
+// rules, scanning each input whole from the start state.
+int record_profile(const Options& options){
+    fsa::CompileOptions compile_options;
+    compile_options.anchored = options.anchored;
+    fsa::DFA dfa = fsa::compile(load_patterns(options), compile_options);
+    fsa::Profile profile(dfa);
+    bool failed = false;
+    if(options.files.empty()){
+        std::string text = read_stdin();
+        if(!options.skip_binary || !is_binary(text)) profile.train(dfa, text);
+    }
+    for(const std::string& file : options.files){
+        try{
+            if(options.decompress){
+                fsa::DecompressedReader reader(file);
+                std::string text;
+                for(std::string_view chunk = reader.next(); !chunk.empty(); chunk = reader.next()) text.append(chunk);
+                if(!options.skip_binary || !is_binary(text)) profile.train(dfa, text);
+                continue;
+            }
+            fsa::MappedFile input(file);
+            if(!options.skip_binary || !is_binary(input.view())) profile.train(dfa, input.view());
+        }catch(const std::exception& e){
+            std::cerr << "Regex: " << e.what() << "\n";
+            failed = true;
+        }
+    }
+    std::ofstream out(options.profile_file, std::ios::trunc);
+    if(!out) throw std::runtime_error("cannot create " + options.profile_file);
+    profile.save(out);
+    if(!out.flush()) throw std::runtime_error("cannot write " + options.profile_file);
+    return failed ? 2 : 0;
+}
+
+int connect(const std::string& socket, const std::vector<std::string>& files){
+    fsa::MatchClient client(socket);
+    std::vector<std::string> names;
+    std::vector<fsa::MappedFile> mapped;
+    std::string input;
+    std::vector<std::string_view> buffers;
+    if(files.empty()){
+        input = read_stdin();
+        names.push_back(STDIN_NAME);
+        buffers.push_back(input);
+    }
+    for(const std::string& file : files){
+        mapped.emplace_back(file);
+        names.push_back(file);
+        buffers.push_back(mapped.back().view());
+    }
+    std::vector<std::vector<fsa::PatternId>> results = client.match(buffers);
+    bool matched = false;
+    for(size_t i = 0; i < results.size(); i++) matched |= report(names[i], results[i]);
+    return matched ? 0 : 1;
+}
+
+int serve(const fsa::BundleView& rules, const std::string& socket){
+    // Stop cleanly on SIGINT or SIGTERM so the socket file is removed.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    fsa::MatchServer server(rules, socket);
+    std::thread watcher([&server, signals]{
+        int signal;
+        sigwait(&signals, &signal);
+        server.stop();
+    });
+    watcher.detach();
+    std::cerr << "Regex: serving " << rules.pattern_count() << " patterns on " << socket << "\n";
+    server.serve();
     return 0;
-}
\ No newline at end of file
+}
+
+}
+
+int main(int argc, char** argv){
+    Options options;
+    bool have_rules = false;
+    std::vector<std::string> positional;
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "-e" && has_value){
+            options.patterns.push_back(argv[++i]);
+            have_rules = true;
+        }else if(arg == "-f" && has_value){
+            options.rules_file = argv[++i];
+            have_rules = true;
+        }else if(arg == "-b" && has_value){
+            options.bundle_file = argv[++i];
+            have_rules = true;
+        }else if(arg == "--daemon" && has_value){
+            options.daemon_socket = argv[++i];
+        }else if(arg == "--connect" && has_value){
+            options.connect_socket = argv[++i];
+        }else if(arg == "--record-profile" && has_value){
+            options.profile_file = argv[++i];
+        }else if(arg == "--anchored"){
+            options.anchored = true;
+        }else if(arg == "--lines"){
+            options.lines = true;
+        }else if(arg == "-c"){
+            options.lines = options.count = true;
+        }else if(arg == "-v"){
+            options.lines = options.invert = true;
+        }else if(arg == "--records" && has_value){
+            char* end;
+            options.record_size = std::strtoul(argv[++i], &end, 10);
+            if(*end || options.record_size == 0) return usage();
+        }else if(arg == "-r"){
+            options.recursive = true;
+        }else if(arg == "--ignore" && has_value){
+            options.walk.ignore.push_back(argv[++i]);
+        }else if(arg == "--no-ignore"){
+            options.walk.ignore_files = false;
+        }else if(arg == "-I"){
+            options.skip_binary = true;
+        }else if(arg == "-z"){
+            options.decompress = true;
+        }else if(arg == "--uring"){
+            options.uring = true;
+        }else if(arg == "--"){
+            options.files.insert(options.files.end(), argv + i + 1, argv + argc);
+            break;
+        }else if(arg.size() > 1 && arg[0] == '-'){
+            return usage();
+        }else{
+            positional.push_back(arg);
+        }
+    }
+    if(!options.connect_socket.empty()){
+        // The daemon has its rules and answers whole-buffer match sets;
+        // nothing that changes either can be honoured by the client.
+        const char* conflict = have_rules ? "-e, -f or -b"
+            : options.anchored ? "--anchored"
+            : options.lines ? "--lines, -c or -v"
+            : options.record_size ? "--records"
+            : options.recursive ? "-r"
+            : options.skip_binary ? "-I"
+            : options.decompress ? "-z"
+            : options.uring ? "--uring"
+            : !options.daemon_socket.empty() ? "--daemon"
+            : !options.profile_file.empty() ? "--record-profile"
+            : nullptr;
+        if(conflict){
+            std::cerr << "Regex: --connect cannot be combined with " << conflict << "\n";
+            return 2;
+        }
+    }else if(!have_rules && !positional.empty()){
+        options.patterns.push_back(positional.front());
+        positional.erase(positional.begin());
+        have_rules = true;
+    }
+    options.files.insert(options.files.begin(), positional.begin(), positional.end());
+    if(!options.bundle_file.empty() && (!options.patterns.empty() || !options.rules_file.empty())){
+        std::cerr << "Regex: -b cannot be combined with -e or -f\n";
+        return 2;
+    }
+    if(!options.profile_file.empty() && (!options.bundle_file.empty() || !options.daemon_socket.empty())){
+        std::cerr << "Regex: --record-profile needs -e or -f rules, not -b or --daemon\n";
+        return 2;
+    }
+
+    try{
+        if(!options.connect_socket.empty()) return connect(options.connect_socket, options.files);
+        if(!have_rules) return usage();
+        std::unique_ptr<Rules> rules;
+        if(options.profile_file.empty()) rules = std::make_unique<Rules>(options);
+        if(!options.daemon_socket.empty()) return serve(rules->view(), options.daemon_socket);
+        bool walk_failed = false;
+        if(options.recursive){
+            std::vector<std::string> roots = options.files.empty() ? std::vector<std::string>{"."} : options.files;
+            std::vector<std::string> errors;
+            options.files = fsa::walk_files(roots, options.walk, &errors);
+            for(const std::string& error : errors) std::cerr << "Regex: " << error << "\n";
+            walk_failed = !errors.empty();
+            if(options.files.empty()) return walk_failed ? 2 : 1;
+        }
+        int status = rules ? scan(rules->view(), options) : record_profile(options);
+        return walk_failed ? 2 : status;
+    }catch(const std::exception& e){
+        std::cerr << "Regex: " << e.what() << "\n";
+    }
+    return 2;
+}
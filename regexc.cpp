@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bundle.h"
+#include "compile.h"
+#include "profile.h"
+#include "rules.h"
+
+namespace {
+
+int usage(){
+    std::cerr << "usage: regexc [--anchored] [--max-states N] [--profile FILE] RULES OUTPUT\n"
+                 "Compiles one pattern per line of RULES into a bundle for Regex.\n"
+                 "A profile from Regex --record-profile over sample input, with the\n"
+                 "same rules, lays out the states it saw most often first.\n";
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv){
+    fsa::CompileOptions options;
+    std::vector<std::string> files;
+    std::string profile_file;
+    for(int i = 1; i < argc; i++){
+        if(std::strcmp(argv[i], "--anchored") == 0){
+            options.anchored = true;
+        }else if(std::strcmp(argv[i], "--max-states") == 0 && i + 1 < argc){
+            char* end;
+            options.max_states = std::strtoull(argv[++i], &end, 10);
+            if(*end || options.max_states == 0) return usage();
+        }else if(std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            profile_file = argv[++i];
+        }else if(argv[i][0] == '-' && argv[i][1] != '\0'){
+            return usage();
+        }else{
+            files.push_back(argv[i]);
+        }
+    }
+    if(files.size() != 2) return usage();
+
+    std::ifstream in(files[0]);
+    if(!in){
+        std::cerr << "regexc: cannot open " << files[0] << "\n";
+        return 1;
+    }
+    std::vector<size_t> lines;
+    std::vector<std::string> rules = fsa::read_rules(in, &lines);
+    for(size_t i = 0; i < rules.size(); i++){
+        try{
+            fsa::parse(rules[i]);
+        }catch(const fsa::ParseError& e){
+            std::cerr << files[0] << ":" << lines[i] << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    fsa::Profile profile;
+    if(!profile_file.empty()){
+        std::ifstream profile_in(profile_file);
+        if(!profile_in){
+            std::cerr << "regexc: cannot open " << profile_file << "\n";
+            return 1;
+        }
+        try{
+            profile = fsa::Profile::load(profile_in, options.max_states);
+        }catch(const std::runtime_error& e){
+            std::cerr << profile_file << ": " << e.what() << "\n";
+            return 1;
+        }
+        options.profile = &profile;
+    }
+
+    fsa::DFA dfa;
+    try{
+        dfa = fsa::compile(rules, options);
+    }catch(const fsa::StateLimitError& e){
+        std::cerr << "regexc: " << e.what() << "; split the rules or raise --max-states\n";
+        return 1;
+    }
+    if(options.profile){
+        // compile() drops a profile that no longer fits the rules; the
+        // result is then neither the profiled DFA nor its reordering.
+        try{
+            profile.hot_states(dfa, 1.0);
+        }catch(const std::invalid_argument&){
+            std::cerr << "regexc: " << profile_file << " was recorded on other rules or options; ignored\n";
+        }
+    }
+
+    std::ofstream out(files[1], std::ios::binary | std::ios::trunc);
+    if(!out){
+        std::cerr << "regexc: cannot create " << files[1] << "\n";
+        return 1;
+    }
+    try{
+        fsa::write_bundle(dfa, out);
+    }catch(const std::exception& e){
+        std::cerr << "regexc: " << e.what() << "\n";
+        return 1;
+    }
+    std::cerr << rules.size() << " rules, " << dfa.size() << " states, "
+              << dfa.byte_classes().count << " byte classes\n";
+    return 0;
+}
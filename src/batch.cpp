@@ -0,0 +1,16 @@
+#include "batch.h"
+
+namespace fsa {
+
+std::vector<bool> absorbing_states(const DFA& dfa){
+    std::vector<bool> absorbing(dfa.size(), false);
+    for(StateId s = 0; s < dfa.size(); s++){
+        const StateId* row = dfa.row(s);
+        bool loops = true;
+        for(int b = 0; b < 256 && loops; b++) loops = row[b] == s;
+        absorbing[s] = loops;
+    }
+    return absorbing;
+}
+
+}
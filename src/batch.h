@@ -0,0 +1,218 @@
+#ifndef FSA_BATCH_H
+#define FSA_BATCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// Inputs scanned side by side by the batch loops. Each lane's next-state
+// lookup is independent of the others, so their cache misses overlap
+// instead of each waiting on the one before.
+constexpr size_t BATCH_LANES = 4;
+
+// States every byte leads back to: once there, the rest of an input
+// cannot change the outcome, so batch loops stop early. For a LIKE
+// pattern ending in '%' this is the state after the last literal.
+std::vector<bool> absorbing_states(const DFA& dfa);
+
+namespace detail {
+
+// The lane loop behind every batch entry point. input(i, first, last)
+// sets the byte range of input i, or returns false to skip it (a null
+// row); output(i, matched) receives each result, in completion order.
+template <bool Find, class Automaton, class Input, class Output>
+void batch_loop(const Automaton& a, size_t count, Input&& input, Output&& output,
+                const std::vector<bool>* absorbing){
+    struct Lane {
+        size_t input;
+        const unsigned char* p;
+        const unsigned char* end;
+        StateId s;
+    };
+    auto settled = [&](StateId s){
+        if(s == Automaton::DEAD) return true;
+        if(Find && a.accepting(s)) return true;
+        return absorbing && (*absorbing)[s];
+    };
+    auto result = [&](StateId s){ return s != Automaton::DEAD && a.accepting(s); };
+
+    size_t next = 0;
+    // Starts the next unfinished input in the lane; false when none are left.
+    auto refill = [&](Lane& lane){
+        while(next < count){
+            size_t i = next++;
+            const unsigned char* first;
+            const unsigned char* last;
+            if(!input(i, first, last)) continue;
+            StateId s = a.start();
+            if(first == last || settled(s)){
+                output(i, result(s));
+                continue;
+            }
+            lane = {i, first, last, s};
+            return true;
+        }
+        return false;
+    };
+
+    Lane lanes[BATCH_LANES];
+    size_t active = 0;
+    while(active < BATCH_LANES && refill(lanes[active])) active++;
+    while(active > 0){
+        for(size_t k = 0; k < active;){
+            Lane& lane = lanes[k];
+            lane.s = a.next(lane.s, *lane.p++);
+            if(lane.p == lane.end || settled(lane.s)){
+                output(lane.input, result(lane.s));
+                if(!refill(lane)){
+                    lane = lanes[--active];
+                    continue;
+                }
+            }
+            k++;
+        }
+    }
+}
+
+// Lane loop for packed records of one width. Lanes step in lockstep
+// through a group of records, so the end of a record is one check per
+// byte offset instead of one per lane; lanes that settle early drop out.
+template <bool Find, class Automaton, class Output>
+void record_loop(const Automaton& a, const uint8_t* data, size_t record_size, size_t records,
+                 Output&& output, const std::vector<bool>* absorbing){
+    auto settled = [&](StateId s){
+        if(s == Automaton::DEAD) return true;
+        if(Find && a.accepting(s)) return true;
+        return absorbing && (*absorbing)[s];
+    };
+    auto result = [&](StateId s){ return s != Automaton::DEAD && a.accepting(s); };
+
+    StateId start = a.start();
+    if(record_size == 0 || settled(start)){
+        for(size_t i = 0; i < records; i++) output(i, result(start));
+        return;
+    }
+    for(size_t base = 0; base < records; base += BATCH_LANES){
+        const uint8_t* p[BATCH_LANES];
+        StateId s[BATCH_LANES];
+        size_t id[BATCH_LANES];
+        size_t active = std::min(BATCH_LANES, records - base);
+        for(size_t k = 0; k < active; k++){
+            id[k] = base + k;
+            p[k] = data + id[k] * record_size;
+            s[k] = start;
+        }
+        for(size_t j = 0; j < record_size && active > 0; j++){
+            for(size_t k = 0; k < active;){
+                s[k] = a.next(s[k], p[k][j]);
+                if(settled(s[k])){
+                    output(id[k], result(s[k]));
+                    active--;
+                    p[k] = p[active];
+                    s[k] = s[active];
+                    id[k] = id[active];
+                    continue;
+                }
+                k++;
+            }
+        }
+        for(size_t k = 0; k < active; k++) output(id[k], result(s[k]));
+    }
+}
+
+template <bool Find, class Automaton>
+void batch_views(const Automaton& a, const std::string_view* inputs, size_t count, uint8_t* results,
+                 const std::vector<bool>* absorbing){
+    auto input = [inputs](size_t i, const unsigned char*& first, const unsigned char*& last){
+        first = reinterpret_cast<const unsigned char*>(inputs[i].data());
+        last = first + inputs[i].size();
+        return true;
+    };
+    auto output = [results](size_t i, bool matched){ results[i] = matched; };
+    batch_loop<Find>(a, count, input, output, absorbing);
+}
+
+}
+
+// results[i] = whether the whole of inputs[i] is accepted (accepts()), for
+// an anchored automaton.
+template <class Automaton>
+void accepts_batch(const Automaton& a, const std::string_view* inputs, size_t count, uint8_t* results,
+                   const std::vector<bool>* absorbing = nullptr){
+    detail::batch_views<false>(a, inputs, count, results, absorbing);
+}
+
+// results[i] = whether some prefix of inputs[i] reaches an accepting state
+// (find()); with an unanchored automaton, whether any pattern occurs.
+template <class Automaton>
+void find_batch(const Automaton& a, const std::string_view* inputs, size_t count, uint8_t* results,
+                const std::vector<bool>* absorbing = nullptr){
+    detail::batch_views<true>(a, inputs, count, results, absorbing);
+}
+
+// A column of strings in the Arrow layout: row i is the bytes
+// data[offsets[i], offsets[i + 1]). Offset is int32_t for Arrow's string
+// type and int64_t for large_string.
+template <class Offset>
+struct StringColumn {
+    const Offset* offsets;
+    const uint8_t* data;
+    size_t rows;
+    // Arrow validity bitmap (bit i set: row i is not null), or nullptr.
+    const uint8_t* validity = nullptr;
+};
+
+struct ColumnFilter {
+    // Select rows the automaton accepts whole (accepts()); otherwise rows
+    // with a match anywhere a scan from the start reaches (find()).
+    bool whole_value = true;
+    // From absorbing_states(), to stop rows early; optional.
+    const std::vector<bool>* absorbing = nullptr;
+};
+
+// Writes the selection bitmap for a column: bit i (least significant bit
+// first, as Arrow orders bits) is set when row i matches. `selection`
+// holds (rows + 7) / 8 bytes and is overwritten. Null rows are never
+// selected. Rows are fed straight from the offsets into the batch lanes;
+// no per-row string_view is built.
+template <class Automaton, class Offset>
+void filter_column(const Automaton& a, const StringColumn<Offset>& column, uint8_t* selection,
+                   const ColumnFilter& filter = {}){
+    std::memset(selection, 0, (column.rows + 7) / 8);
+    auto input = [&column](size_t i, const unsigned char*& first, const unsigned char*& last){
+        if(column.validity && !(column.validity[i >> 3] >> (i & 7) & 1)) return false;
+        first = column.data + column.offsets[i];
+        last = column.data + column.offsets[i + 1];
+        return true;
+    };
+    auto output = [selection](size_t i, bool matched){
+        if(matched) selection[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+    };
+    if(filter.whole_value) detail::batch_loop<false>(a, column.rows, input, output, filter.absorbing);
+    else detail::batch_loop<true>(a, column.rows, input, output, filter.absorbing);
+}
+
+// The same selection bitmap for packed fixed-width records with no
+// delimiters: record i is data[i * record_size, (i + 1) * record_size).
+// The automaton restarts at every record, so with an unanchored one and
+// whole_value off a record is selected when a pattern occurs inside it.
+template <class Automaton>
+void filter_records(const Automaton& a, const uint8_t* data, size_t record_size, size_t records,
+                    uint8_t* selection, const ColumnFilter& filter = {}){
+    std::memset(selection, 0, (records + 7) / 8);
+    auto output = [selection](size_t i, bool matched){
+        if(matched) selection[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+    };
+    if(filter.whole_value) detail::record_loop<false>(a, data, record_size, records, output, filter.absorbing);
+    else detail::record_loop<true>(a, data, record_size, records, output, filter.absorbing);
+}
+
+}
+
+#endif
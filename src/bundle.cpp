@@ -0,0 +1,105 @@
+#include "bundle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "scan.h"
+
+namespace fsa {
+
+BundleView::BundleView(const void* data, size_t size){
+    auto fail = [](const char* why){ throw std::runtime_error(std::string("invalid bundle: ") + why); };
+    if(reinterpret_cast<uintptr_t>(data) % 4 != 0) fail("misaligned");
+    if(size < sizeof(BundleHeader)) fail("truncated header");
+    header_ = static_cast<const BundleHeader*>(data);
+    if(std::memcmp(header_->magic, BUNDLE_MAGIC, 4) != 0) fail("bad magic");
+    if(header_->version != BUNDLE_VERSION) fail("unsupported version");
+    if(header_->byte_order != BUNDLE_BYTE_ORDER) fail("written with a different byte order");
+    if(header_->engine != static_cast<uint32_t>(Engine::DenseDFA)) fail("unknown engine");
+    classes_ = header_->classes;
+    if(classes_ == 0 || classes_ > 256) fail("bad class count");
+    if(header_->start != DEAD && header_->start >= header_->states) fail("bad start state");
+
+    uint64_t states = header_->states;
+    uint64_t need = sizeof(BundleHeader) + 512 + 4 * (states * classes_ + states + 1 + header_->match_count);
+    if(size < need) fail("truncated");
+
+    const uint8_t* p = static_cast<const uint8_t*>(data) + sizeof(BundleHeader);
+    byte_class_ = p;
+    leaves_start_ = p + 256;
+    next_ = reinterpret_cast<const uint32_t*>(p + 512);
+    match_begin_ = next_ + states * classes_;
+    match_ids_ = match_begin_ + states + 1;
+    for(int b = 0; b < 256; b++){
+        if(byte_class_[b] >= classes_) fail("bad byte class");
+    }
+}
+
+bool BundleView::verify() const {
+    size_t states = header_->states;
+    for(size_t i = 0; i < states * classes_; i++){
+        if(next_[i] != DEAD && next_[i] >= states) return false;
+    }
+    if(match_begin_[0] != 0 || match_begin_[states] != header_->match_count) return false;
+    for(size_t s = 0; s < states; s++){
+        if(match_begin_[s] > match_begin_[s + 1]) return false;
+    }
+    for(uint32_t i = 0; i < header_->match_count; i++){
+        if(match_ids_[i] >= header_->patterns) return false;
+    }
+    return true;
+}
+
+bool BundleView::find(std::string_view text) const {
+    StateId s = start();
+    if(s == DEAD) return false;
+    if(accepting(s)) return true;
+    bool skipping = prefilter();
+    size_t i = 0;
+    while(i < text.size()){
+        if(skipping && s == start()){
+            i = skip(text, i);
+            if(i == text.size()) break;
+        }
+        s = next(s, static_cast<uint8_t>(text[i++]));
+        if(s == DEAD) return false;
+        if(accepting(s)) return true;
+    }
+    return false;
+}
+
+bool BundleView::accepts(std::string_view text) const {
+    return scan_accepts(*this, text);
+}
+
+std::vector<PatternId> BundleView::match_set(std::string_view text) const {
+    if(!prefilter()) return scan_match_set(*this, text);
+    std::vector<bool> seen(pattern_count(), false);
+    std::vector<PatternId> found;
+    auto collect = [&](StateId s){
+        for(PatternId p : matches(s)){
+            if(!seen[p]){
+                seen[p] = true;
+                found.push_back(p);
+            }
+        }
+    };
+    StateId s = start();
+    if(s == DEAD) return found;
+    collect(s);
+    size_t i = 0;
+    while(i < text.size() && found.size() < pattern_count()){
+        if(s == start()){
+            i = skip(text, i);
+            if(i == text.size()) break;
+        }
+        s = next(s, static_cast<uint8_t>(text[i++]));
+        if(s == DEAD) break;
+        if(accepting(s)) collect(s);
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef FSA_BUNDLE_H
+#define FSA_BUNDLE_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// Serialized, ready-to-run automaton written by the regexc tool. The file
+// is a header followed by fixed sections, all in host byte order and
+// 4-byte aligned, so a mapped file is used in place:
+//
+//   BundleHeader
+//   uint8_t  byte_class[256]
+//   uint8_t  leaves_start[256]          1 if the byte leaves the start state
+//   uint32_t next[states * classes]     next state by (state, class)
+//   uint32_t match_begin[states + 1]
+//   uint32_t match_ids[match_count]
+
+enum class Engine : uint32_t {
+    // Dense transition table indexed by byte class.
+    DenseDFA = 1,
+};
+
+enum BundleFlags : uint32_t {
+    BUNDLE_ANCHORED = 1,
+    // Few bytes leave the start state, so skipping ahead while in it pays.
+    BUNDLE_PREFILTER = 2,
+};
+
+struct BundleHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t engine;
+    uint32_t flags;
+    uint32_t states;
+    uint32_t patterns;
+    uint32_t start;
+    uint32_t classes;
+    uint32_t match_count;
+};
+
+constexpr char BUNDLE_MAGIC[4] = {'F', 'S', 'A', 'B'};
+constexpr uint32_t BUNDLE_VERSION = 1;
+constexpr uint32_t BUNDLE_BYTE_ORDER = 0x01020304;
+
+// Writes `dfa` as a bundle.
+void write_bundle(const DFA& dfa, std::ostream& out);
+// The same bundle in memory, in words so BundleView's alignment holds.
+std::vector<uint32_t> build_bundle(const DFA& dfa);
+
+// Matcher over a bundle in memory, usually a MappedFile. Only validates
+// and reads; nothing is parsed or built. The memory must outlive the view
+// and be 4-byte aligned.
+class BundleView {
+public:
+    static constexpr StateId DEAD = DFA::DEAD;
+
+    // Throws std::runtime_error if the data is not a well-formed bundle for
+    // this build (wrong magic, version, byte order or sizes). Only the
+    // header is checked, so opening a bundle does not touch the table.
+    BundleView(const void* data, size_t size);
+
+    // Checks every state id and match list in the bundle; use it on
+    // bundles that do not come from a trusted regexc run.
+    bool verify() const;
+
+    StateId next(StateId state, uint8_t byte) const {
+        return next_[static_cast<size_t>(state) * classes_ + byte_class_[byte]];
+    }
+
+    StateId start() const { return header_->start; }
+    bool anchored() const { return header_->flags & BUNDLE_ANCHORED; }
+    Engine engine() const { return static_cast<Engine>(header_->engine); }
+    bool prefilter() const { return header_->flags & BUNDLE_PREFILTER; }
+    bool accepting(StateId state) const { return match_begin_[state] != match_begin_[state + 1]; }
+    MatchLists::Range matches(StateId state) const {
+        return {match_ids_ + match_begin_[state], match_ids_ + match_begin_[state + 1]};
+    }
+    size_t size() const { return header_->states; }
+    size_t pattern_count() const { return header_->patterns; }
+    unsigned byte_class(uint8_t byte) const { return byte_class_[byte]; }
+    unsigned class_count() const { return classes_; }
+    bool leaves_start(uint8_t byte) const { return leaves_start_[byte]; }
+
+    // Offset of the first byte at or after `from` that leaves the start
+    // state, or text.size(). Scans use it while in the start state.
+    size_t skip(std::string_view text, size_t from) const {
+        while(from < text.size() && !leaves_start_[static_cast<unsigned char>(text[from])]) from++;
+        return from;
+    }
+
+    bool find(std::string_view text) const;
+    bool accepts(std::string_view text) const;
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    const BundleHeader* header_;
+    const uint8_t* byte_class_;
+    const uint8_t* leaves_start_;
+    const uint32_t* next_;
+    const uint32_t* match_begin_;
+    const uint32_t* match_ids_;
+    uint32_t classes_;
+};
+
+}
+
+#endif
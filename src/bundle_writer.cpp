@@ -0,0 +1,79 @@
+#include "bundle.h"
+
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace fsa {
+
+namespace {
+
+// Start states left by at most this many bytes get the skip loop.
+constexpr unsigned PREFILTER_MAX_BYTES = 64;
+
+template <class T>
+void put(std::ostream& out, const T* data, size_t count){
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+}
+
+void write_bundle(const DFA& dfa, std::ostream& out){
+    ByteClasses classes = dfa.byte_classes();
+    std::vector<uint8_t> reps = classes.representatives();
+    MatchLists matches(dfa);
+
+    BundleHeader header{};
+    std::memcpy(header.magic, BUNDLE_MAGIC, 4);
+    header.version = BUNDLE_VERSION;
+    header.byte_order = BUNDLE_BYTE_ORDER;
+    header.engine = static_cast<uint32_t>(Engine::DenseDFA);
+    header.states = static_cast<uint32_t>(dfa.size());
+    header.patterns = static_cast<uint32_t>(dfa.pattern_count());
+    header.start = dfa.start();
+    header.classes = classes.count;
+
+    std::vector<uint8_t> leaves_start(256, 0);
+    unsigned leaving = 0;
+    if(dfa.start() != DFA::DEAD){
+        for(int b = 0; b < 256; b++){
+            leaves_start[b] = dfa.next(dfa.start(), static_cast<uint8_t>(b)) != dfa.start();
+            leaving += leaves_start[b];
+        }
+        if(leaving <= PREFILTER_MAX_BYTES) header.flags |= BUNDLE_PREFILTER;
+    }
+    if(dfa.anchored()) header.flags |= BUNDLE_ANCHORED;
+
+    std::vector<uint32_t> next;
+    next.reserve(dfa.size() * classes.count);
+    for(StateId s = 0; s < dfa.size(); s++){
+        for(uint8_t rep : reps) next.push_back(dfa.next(s, rep));
+    }
+    std::vector<uint32_t> match_begin{0};
+    std::vector<uint32_t> match_ids;
+    for(StateId s = 0; s < dfa.size(); s++){
+        for(PatternId p : matches[s]) match_ids.push_back(p);
+        match_begin.push_back(static_cast<uint32_t>(match_ids.size()));
+    }
+    header.match_count = static_cast<uint32_t>(match_ids.size());
+
+    put(out, &header, 1);
+    put(out, classes.of.data(), 256);
+    put(out, leaves_start.data(), 256);
+    put(out, next.data(), next.size());
+    put(out, match_begin.data(), match_begin.size());
+    put(out, match_ids.data(), match_ids.size());
+    if(!out) throw std::runtime_error("failed writing bundle");
+}
+
+std::vector<uint32_t> build_bundle(const DFA& dfa){
+    std::ostringstream out;
+    write_bundle(dfa, out);
+    std::string bytes = out.str();
+    std::vector<uint32_t> words((bytes.size() + 3) / 4, 0);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return words;
+}
+
+}
@@ -0,0 +1,121 @@
+#include "comb.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "scan.h"
+
+namespace fsa {
+
+CombDFA::CombDFA(const DFA& dfa)
+    : classes_(dfa.byte_classes()), base_(dfa.size(), 0), default_(dfa.size(), DEAD),
+      matches_(dfa), start_(dfa.start()), anchored_(dfa.anchored()), patterns_(dfa.pattern_count()){
+    std::vector<uint8_t> reps = classes_.representatives();
+    unsigned width = classes_.count;
+
+    // Non-default entries of every state as (class, target).
+    std::vector<std::vector<std::pair<uint8_t, StateId>>> rows(dfa.size());
+    std::unordered_map<StateId, unsigned> tally;
+    for(StateId s = 0; s < dfa.size(); s++){
+        tally.clear();
+        StateId best = DEAD;
+        unsigned best_count = 0;
+        for(uint8_t rep : reps){
+            unsigned n = ++tally[dfa.next(s, rep)];
+            if(n > best_count){
+                best_count = n;
+                best = dfa.next(s, rep);
+            }
+        }
+        default_[s] = best;
+        for(unsigned c = 0; c < width; c++){
+            StateId t = dfa.next(s, reps[c]);
+            if(t != best) rows[s].emplace_back(static_cast<uint8_t>(c), t);
+        }
+    }
+
+    // First fit, widest rows first: they are the hardest to place.
+    std::vector<StateId> order(dfa.size());
+    for(StateId s = 0; s < dfa.size(); s++) order[s] = s;
+    std::stable_sort(order.begin(), order.end(), [&rows](StateId a, StateId b){
+        return rows[a].size() > rows[b].size();
+    });
+
+    // free_after[i] leads, through path-compressed links, to the first free
+    // slot at or after i, so a failed fit jumps straight to the next base
+    // that puts the row's leading class on a free slot.
+    std::vector<bool> taken;
+    std::vector<size_t> free_after;
+    auto next_free = [&](size_t i){
+        size_t root = i;
+        while(root < free_after.size() && free_after[root] != root) root = free_after[root];
+        while(i < free_after.size() && free_after[i] != i){
+            size_t up = free_after[i];
+            free_after[i] = root;
+            i = up;
+        }
+        return root;
+    };
+    for(StateId s : order){
+        const auto& row = rows[s];
+        if(row.empty()) continue;
+        size_t lead = row.front().first;
+        size_t slot = next_free(lead);
+        size_t base;
+        while(true){
+            base = slot - lead;
+            bool fits = true;
+            for(const auto& entry : row){
+                size_t i = base + entry.first;
+                if(i < taken.size() && taken[i]){
+                    fits = false;
+                    break;
+                }
+            }
+            if(fits) break;
+            slot = next_free(slot + 1);
+        }
+        base_[s] = static_cast<uint32_t>(base);
+        size_t end = base + width;
+        if(end > taken.size()){
+            size_t old_size = free_after.size();
+            taken.resize(end, false);
+            next_.resize(end, DEAD);
+            check_.resize(end, DEAD);
+            free_after.resize(end);
+            for(size_t i = old_size; i < end; i++) free_after[i] = i;
+        }
+        for(const auto& entry : row){
+            size_t i = base + entry.first;
+            taken[i] = true;
+            next_[i] = entry.second;
+            check_[i] = s;
+            free_after[i] = i + 1;
+        }
+        used_ += row.size();
+    }
+    // Every state may be probed at base + class for any class.
+    if(next_.size() < width){
+        next_.resize(width, DEAD);
+        check_.resize(width, DEAD);
+    }
+}
+
+size_t CombDFA::memory_usage() const {
+    return sizeof(classes_.of) + base_.size() * sizeof(uint32_t) + default_.size() * sizeof(StateId)
+        + next_.size() * sizeof(StateId) + check_.size() * sizeof(StateId) + matches_.memory_usage();
+}
+
+bool CombDFA::find(std::string_view text) const {
+    return scan_find(*this, text);
+}
+
+bool CombDFA::accepts(std::string_view text) const {
+    return scan_accepts(*this, text);
+}
+
+std::vector<PatternId> CombDFA::match_set(std::string_view text) const {
+    return scan_match_set(*this, text);
+}
+
+}
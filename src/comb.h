@@ -0,0 +1,58 @@
+#ifndef FSA_COMB_H
+#define FSA_COMB_H
+
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// Row-displacement ("comb") compressed DFA, the base/next/check layout of
+// classic lexer generators. Each state keeps its most common target as a
+// default; its other transitions, indexed by byte class, are overlaid into
+// one shared array at offset base[state], and check[] records which state
+// owns each slot. Lookup is two loads and a compare. State ids are the same
+// as in the source DFA.
+class CombDFA {
+public:
+    static constexpr StateId DEAD = DFA::DEAD;
+
+    explicit CombDFA(const DFA& dfa);
+
+    StateId next(StateId state, uint8_t byte) const {
+        size_t i = static_cast<size_t>(base_[state]) + classes_.of[byte];
+        return check_[i] == state ? next_[i] : default_[state];
+    }
+
+    StateId start() const { return start_; }
+    bool anchored() const { return anchored_; }
+    bool accepting(StateId state) const { return matches_.accepting(state); }
+    MatchLists::Range matches(StateId state) const { return matches_[state]; }
+    size_t size() const { return base_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    // Slots in the shared next/check arrays, and how many of them are used.
+    size_t slots() const { return next_.size(); }
+    size_t used_slots() const { return used_; }
+    size_t memory_usage() const;
+
+    bool find(std::string_view text) const;
+    bool accepts(std::string_view text) const;
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    ByteClasses classes_;
+    std::vector<uint32_t> base_;
+    std::vector<StateId> default_;
+    std::vector<StateId> next_;
+    std::vector<StateId> check_;
+    MatchLists matches_;
+    StateId start_;
+    bool anchored_;
+    size_t patterns_;
+    size_t used_ = 0;
+};
+
+}
+
+#endif
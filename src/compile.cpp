@@ -0,0 +1,28 @@
+#include "compile.h"
+
+#include "layout.h"
+#include "profile.h"
+
+namespace fsa {
+
+DFA compile(const std::vector<std::string>& patterns, const CompileOptions& options){
+    NFA nfa;
+    for(const std::string& pattern : patterns) nfa.add(pattern);
+    return compile(nfa, options);
+}
+
+DFA compile(const NFA& nfa, const CompileOptions& options){
+    DFA dfa = determinize(nfa, options.anchored, options.max_states);
+    if(options.minimize) dfa = minimize(dfa);
+    dfa = renumber(dfa, bfs_order(dfa));
+    if(options.profile && options.profile->fits(dfa)){
+        dfa = renumber(dfa, hot_order(dfa, options.profile->state_weights()));
+    }
+    return dfa;
+}
+
+DFA compile(std::string_view pattern, const CompileOptions& options){
+    return compile(std::vector<std::string>{std::string(pattern)}, options);
+}
+
+}
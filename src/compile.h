@@ -0,0 +1,34 @@
+#ifndef FSA_COMPILE_H
+#define FSA_COMPILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+class Profile;
+
+struct CompileOptions {
+    bool anchored = false;
+    bool minimize = true;
+    size_t max_states = DEFAULT_STATE_LIMIT;
+    // Recorded on the DFA these patterns compile to without a profile. When
+    // it still fits, states are ordered hottest first; a stale profile (the
+    // patterns changed) is ignored.
+    const Profile* profile = nullptr;
+};
+
+// Parses, determinizes, minimizes and lays out the patterns as one DFA.
+// Pattern i reports PatternId i. States end up in breadth-first order from
+// the start state, so the states a scan touches first are adjacent.
+DFA compile(const std::vector<std::string>& patterns, const CompileOptions& options = {});
+DFA compile(std::string_view pattern, const CompileOptions& options = {});
+// The same pipeline for patterns already added to an NFA.
+DFA compile(const NFA& nfa, const CompileOptions& options = {});
+
+}
+
+#endif
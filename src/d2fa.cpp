@@ -0,0 +1,94 @@
+#include "d2fa.h"
+
+#include <deque>
+#include <unordered_map>
+
+#include "layout.h"
+#include "scan.h"
+
+namespace fsa {
+
+D2FA::D2FA(const DFA& dfa, const D2FAOptions& options)
+    : classes_(dfa.byte_classes()), default_(dfa.size(), DEAD), matches_(dfa),
+      start_(dfa.start()), anchored_(dfa.anchored()), patterns_(dfa.pattern_count()){
+    std::vector<uint8_t> reps = classes_.representatives();
+    unsigned width = classes_.count;
+    size_t n = dfa.size();
+
+    auto majority = [&](StateId s){
+        std::unordered_map<StateId, unsigned> tally;
+        StateId best = DEAD;
+        unsigned best_count = 0;
+        for(uint8_t rep : reps){
+            unsigned c = ++tally[dfa.next(s, rep)];
+            if(c > best_count){
+                best_count = c;
+                best = dfa.next(s, rep);
+            }
+        }
+        return best;
+    };
+
+    // Choose defaults in breadth-first order among recent states with the
+    // same majority target whose own chain leaves room for one more edge.
+    std::vector<unsigned> chain(n, 0);
+    std::unordered_map<StateId, std::deque<StateId>> recent;
+    for(StateId s : bfs_order(dfa)){
+        std::deque<StateId>& bucket = recent[majority(s)];
+        StateId best = DEAD;
+        unsigned best_shared = 0;
+        for(StateId candidate : bucket){
+            if(chain[candidate] >= options.max_chain) continue;
+            unsigned shared = 0;
+            for(uint8_t rep : reps){
+                if(dfa.next(s, rep) == dfa.next(candidate, rep)) shared++;
+            }
+            if(shared > best_shared){
+                best_shared = shared;
+                best = candidate;
+            }
+        }
+        // A default only pays off when it saves more than it costs: each
+        // stored transition takes a label on top of the target.
+        if(best != DEAD && (width - best_shared) * 5 < width * 4){
+            default_[s] = best;
+            chain[s] = chain[best] + 1;
+        }
+        bucket.push_back(s);
+        if(bucket.size() > options.candidates) bucket.pop_front();
+    }
+
+    begin_.reserve(n + 1);
+    for(StateId s = 0; s < n; s++){
+        begin_.push_back(static_cast<uint32_t>(targets_.size()));
+        StateId d = default_[s];
+        for(unsigned c = 0; c < width; c++){
+            StateId t = dfa.next(s, reps[c]);
+            if(d != DEAD && t == dfa.next(d, reps[c])) continue;
+            if(d != DEAD) labels_.push_back(static_cast<uint8_t>(c));
+            targets_.push_back(t);
+        }
+        // Roots store a full row and no labels; keep the arrays aligned.
+        if(d == DEAD) labels_.resize(targets_.size(), 0);
+    }
+    begin_.push_back(static_cast<uint32_t>(targets_.size()));
+}
+
+size_t D2FA::memory_usage() const {
+    return sizeof(classes_.of) + begin_.size() * sizeof(uint32_t) + labels_.size()
+        + targets_.size() * sizeof(StateId) + default_.size() * sizeof(StateId) + matches_.memory_usage();
+}
+
+bool D2FA::find(std::string_view text) const {
+    return scan_find(*this, text);
+}
+
+bool D2FA::accepts(std::string_view text) const {
+    return scan_accepts(*this, text);
+}
+
+std::vector<PatternId> D2FA::match_set(std::string_view text) const {
+    return scan_match_set(*this, text);
+}
+
+}
@@ -0,0 +1,80 @@
+#ifndef FSA_D2FA_H
+#define FSA_D2FA_H
+
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+struct D2FAOptions {
+    // Most default edges one lookup may follow before reaching a state that
+    // stores the byte's transition.
+    unsigned max_chain = 4;
+    // Earlier states compared against each state when choosing its default.
+    unsigned candidates = 64;
+};
+
+// Delayed-input DFA. A state may have a default edge to another state and
+// then stores only the transitions where it differs from that state; any
+// other byte is looked up at the default without consuming input. Defaults
+// always point to states built earlier, so chains are acyclic, and their
+// length is bounded by D2FAOptions::max_chain. State ids are the same as in
+// the source DFA.
+//
+// Defaults are chosen greedily in breadth-first order: each state compares
+// itself with recent states that share its most common target and takes
+// the one with most identical transitions. That finds the near-identical
+// rows union DFAs are full of without an all-pairs comparison.
+class D2FA {
+public:
+    static constexpr StateId DEAD = DFA::DEAD;
+
+    explicit D2FA(const DFA& dfa, const D2FAOptions& options = {});
+
+    StateId next(StateId state, uint8_t byte) const {
+        uint8_t cls = classes_.of[byte];
+        while(true){
+            uint32_t begin = begin_[state];
+            uint32_t end = begin_[state + 1];
+            if(default_[state] == DEAD) return targets_[begin + cls];
+            for(uint32_t i = begin; i < end; i++){
+                if(labels_[i] == cls) return targets_[i];
+            }
+            state = default_[state];
+        }
+    }
+
+    StateId start() const { return start_; }
+    bool anchored() const { return anchored_; }
+    bool accepting(StateId state) const { return matches_.accepting(state); }
+    MatchLists::Range matches(StateId state) const { return matches_[state]; }
+    size_t size() const { return default_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    StateId default_of(StateId state) const { return default_[state]; }
+    // Stored transitions, against size() * byte classes for a dense table.
+    size_t transition_count() const { return targets_.size(); }
+    size_t memory_usage() const;
+
+    bool find(std::string_view text) const;
+    bool accepts(std::string_view text) const;
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    ByteClasses classes_;
+    // States without a default store a full row indexed by class; the rest
+    // store (label, target) pairs for the classes that differ.
+    std::vector<uint32_t> begin_;
+    std::vector<uint8_t> labels_;
+    std::vector<StateId> targets_;
+    std::vector<StateId> default_;
+    MatchLists matches_;
+    StateId start_;
+    bool anchored_;
+    size_t patterns_;
+};
+
+}
+
+#endif
@@ -0,0 +1,345 @@
+#include "daemon.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fsa {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string& what){
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+sockaddr_un socket_address(const std::string& path){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)){
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+// False on end of file before `size` bytes.
+bool read_full(int fd, void* data, size_t size){
+    char* p = static_cast<char*>(data);
+    while(size > 0){
+        ssize_t n = ::read(fd, p, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool send_full(int fd, const void* data, size_t size){
+    const char* p = static_cast<const char*>(data);
+    while(size > 0){
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_full(int fd, const char* data, size_t size){
+    while(size > 0){
+        ssize_t n = ::write(fd, data, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+struct FdList {
+    std::vector<int> fds;
+    ~FdList(){ for(int fd : fds) ::close(fd); }
+};
+
+// Reads the request header, collecting any descriptors sent with it.
+// Returns false on a clean end of stream.
+bool read_header(int fd, uint32_t header[2], FdList& received){
+    char control[CMSG_SPACE(sizeof(int) * wire::MAX_SHARED)];
+    iovec iov{header, 2 * sizeof(uint32_t)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do{
+        n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    }while(n < 0 && errno == EINTR);
+    for(cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)){
+        if(c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for(size_t i = 0; i < count; i++){
+            int received_fd;
+            std::memcpy(&received_fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+            received.fds.push_back(received_fd);
+        }
+    }
+    if(n <= 0) return false;
+    size_t got = static_cast<size_t>(n);
+    return got == 2 * sizeof(uint32_t)
+        || read_full(fd, reinterpret_cast<char*>(header) + got, 2 * sizeof(uint32_t) - got);
+}
+
+}
+
+MatchServer::MatchServer(const BundleView& bundle, const std::string& path)
+    : bundle_(bundle), path_(path){
+    sockaddr_un addr = socket_address(path);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listen_fd_ < 0) throw_errno("socket");
+    ::unlink(path.c_str());
+    if(::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+       || ::listen(listen_fd_, 64) != 0){
+        int err = errno;
+        ::close(listen_fd_);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+}
+
+MatchServer::~MatchServer(){
+    stop();
+    for(Connection& c : connections_) c.thread.join();
+    ::close(listen_fd_);
+    ::unlink(path_.c_str());
+}
+
+void MatchServer::stop(){
+    stopping_ = true;
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for(int fd : clients_) ::shutdown(fd, SHUT_RDWR);
+}
+
+void MatchServer::serve(){
+    while(!stopping_){
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if(fd < 0){
+            if(errno == EINTR || errno == ECONNABORTED) continue;
+            if(stopping_) break;
+            throw_errno("accept");
+        }
+        reap();
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        if(stopping_){
+            ::close(fd);
+            break;
+        }
+        clients_.push_back(fd);
+        Connection& c = connections_.emplace_back();
+        c.thread = std::thread([this, fd, &c]{
+            handle(fd);
+            c.done = true;
+        });
+    }
+}
+
+void MatchServer::reap(){
+    for(auto it = connections_.begin(); it != connections_.end();){
+        if(it->done){
+            it->thread.join();
+            it = connections_.erase(it);
+        }else{
+            ++it;
+        }
+    }
+}
+
+void MatchServer::handle(int fd){
+    std::vector<char> buffer;
+    std::vector<uint32_t> response;
+    while(true){
+        uint32_t header[2];
+        FdList shared;
+        if(!read_header(fd, header, shared)) break;
+        if(header[0] != wire::REQUEST_MAGIC || header[1] > wire::MAX_BATCH) break;
+        response.assign({wire::RESPONSE_MAGIC, header[1]});
+        size_t next_shared = 0;
+        bool ok = true;
+        // A bad memfd fails the request, not the connection: the rest of
+        // the items are still read so the stream stays in step.
+        std::string error;
+        for(uint32_t i = 0; i < header[1] && ok; i++){
+            wire::Item item;
+            if(!read_full(fd, &item, sizeof(item))){
+                ok = false;
+                break;
+            }
+            std::vector<PatternId> found;
+            if(item.kind == wire::INLINE){
+                if(item.length > wire::MAX_INLINE){
+                    ok = false;
+                    break;
+                }
+                buffer.resize(item.length);
+                if(!read_full(fd, buffer.data(), buffer.size())){
+                    ok = false;
+                    break;
+                }
+                found = bundle_.match_set(std::string_view(buffer.data(), buffer.size()));
+            }else if(item.kind == wire::SHARED && next_shared < shared.fds.size()){
+                int memfd = shared.fds[next_shared++];
+                if(error.empty()){
+                    // Without F_SEAL_SHRINK the client could truncate the
+                    // file while it is mapped and fault this thread with
+                    // SIGBUS.
+                    int seals = ::fcntl(memfd, F_GET_SEALS);
+                    struct stat st;
+                    if(seals < 0 || !(seals & F_SEAL_SHRINK)){
+                        error = "shared buffer " + std::to_string(i) + " is not sealed against shrinking";
+                    }else if(::fstat(memfd, &st) != 0 || static_cast<uint64_t>(st.st_size) < item.length){
+                        error = "shared buffer " + std::to_string(i) + " is shorter than its length";
+                    }else if(item.length > 0){
+                        void* p = ::mmap(nullptr, item.length, PROT_READ, MAP_SHARED, memfd, 0);
+                        if(p == MAP_FAILED){
+                            ok = false;
+                            break;
+                        }
+                        found = bundle_.match_set(std::string_view(static_cast<const char*>(p), item.length));
+                        ::munmap(p, item.length);
+                    }else{
+                        found = bundle_.match_set({});
+                    }
+                }
+            }else{
+                ok = false;
+                break;
+            }
+            response.push_back(static_cast<uint32_t>(found.size()));
+            response.insert(response.end(), found.begin(), found.end());
+        }
+        if(!ok) break;
+        if(!error.empty()){
+            uint32_t reply[2] = {wire::ERROR_MAGIC, static_cast<uint32_t>(error.size())};
+            if(!send_full(fd, reply, sizeof(reply)) || !send_full(fd, error.data(), error.size())) break;
+            continue;
+        }
+        if(!send_full(fd, response.data(), response.size() * sizeof(uint32_t))) break;
+    }
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    clients_.erase(std::find(clients_.begin(), clients_.end(), fd));
+    ::close(fd);
+}
+
+MatchClient::MatchClient(const std::string& path, size_t shared_threshold)
+    : shared_threshold_(shared_threshold){
+    sockaddr_un addr = socket_address(path);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd_ < 0) throw_errno("socket");
+    if(::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        int err = errno;
+        ::close(fd_);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+}
+
+MatchClient::~MatchClient(){
+    ::close(fd_);
+}
+
+std::vector<std::vector<PatternId>> MatchClient::match(const std::vector<std::string_view>& buffers){
+    std::vector<std::vector<PatternId>> results(buffers.size());
+    size_t begin = 0;
+    while(begin < buffers.size()){
+        size_t end = begin;
+        uint32_t shared = 0;
+        while(end < buffers.size() && end - begin < wire::MAX_BATCH){
+            bool is_shared = buffers[end].size() >= shared_threshold_ || buffers[end].size() > wire::MAX_INLINE;
+            if(is_shared && shared == wire::MAX_SHARED) break;
+            shared += is_shared;
+            end++;
+        }
+        batch(buffers, begin, end, results);
+        begin = end;
+    }
+    return results;
+}
+
+void MatchClient::batch(const std::vector<std::string_view>& buffers, size_t begin, size_t end,
+                        std::vector<std::vector<PatternId>>& results){
+    FdList memfds;
+    std::vector<wire::Item> items;
+    for(size_t i = begin; i < end; i++){
+        std::string_view b = buffers[i];
+        bool is_shared = b.size() >= shared_threshold_ || b.size() > wire::MAX_INLINE;
+        items.push_back({is_shared ? wire::SHARED : wire::INLINE, 0, b.size()});
+        if(!is_shared) continue;
+        int memfd = ::memfd_create("fsa-buffer", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if(memfd < 0) throw_errno("memfd_create");
+        memfds.fds.push_back(memfd);
+        if(!write_full(memfd, b.data(), b.size())) throw_errno("memfd write");
+        if(::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) != 0) throw_errno("memfd seal");
+    }
+
+    uint32_t header[2] = {wire::REQUEST_MAGIC, static_cast<uint32_t>(end - begin)};
+    iovec iov{header, sizeof(header)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    std::vector<char> control;
+    if(!memfds.fds.empty()){
+        control.resize(CMSG_SPACE(sizeof(int) * memfds.fds.size()));
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int) * memfds.fds.size());
+        std::memcpy(CMSG_DATA(c), memfds.fds.data(), sizeof(int) * memfds.fds.size());
+    }
+    ssize_t sent;
+    do{
+        sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    }while(sent < 0 && errno == EINTR);
+    if(sent < 0) throw_errno("sendmsg");
+    if(static_cast<size_t>(sent) < sizeof(header)
+       && !send_full(fd_, reinterpret_cast<char*>(header) + sent, sizeof(header) - sent)){
+        throw_errno("send");
+    }
+    for(size_t i = begin; i < end; i++){
+        const wire::Item& item = items[i - begin];
+        if(!send_full(fd_, &item, sizeof(item))) throw_errno("send");
+        if(item.kind == wire::INLINE && !send_full(fd_, buffers[i].data(), buffers[i].size())) throw_errno("send");
+    }
+
+    uint32_t reply[2];
+    bool replied = read_full(fd_, reply, sizeof(reply));
+    if(replied && reply[0] == wire::ERROR_MAGIC && reply[1] <= wire::MAX_ERROR){
+        std::string message(reply[1], '\0');
+        if(!read_full(fd_, message.data(), message.size())) throw std::runtime_error("truncated reply from match daemon");
+        throw std::runtime_error("match daemon: " + message);
+    }
+    if(!replied || reply[0] != wire::RESPONSE_MAGIC || reply[1] != end - begin){
+        throw std::runtime_error("match daemon closed the connection or sent a bad reply");
+    }
+    for(size_t i = begin; i < end; i++){
+        uint32_t n;
+        if(!read_full(fd_, &n, sizeof(n))) throw std::runtime_error("truncated reply from match daemon");
+        results[i].resize(n);
+        if(n > 0 && !read_full(fd_, results[i].data(), n * sizeof(PatternId))){
+            throw std::runtime_error("truncated reply from match daemon");
+        }
+    }
+}
+
+}
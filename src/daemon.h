@@ -0,0 +1,115 @@
+#ifndef FSA_DAEMON_H
+#define FSA_DAEMON_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bundle.h"
+
+namespace fsa {
+
+// Wire format between MatchClient and MatchServer over a Unix stream
+// socket, in host byte order (both ends share a machine):
+//
+//   request:  u32 REQUEST_MAGIC, u32 count, then per item
+//             u32 kind, u32 reserved, u64 length, and for INLINE items
+//             `length` payload bytes. SHARED items carry no payload; the
+//             request's first bytes arrive with one memfd per SHARED item
+//             (SCM_RIGHTS, in item order) holding the buffer, sealed
+//             with at least F_SEAL_SHRINK so the server's mapping cannot
+//             lose pages under it.
+//   response: u32 RESPONSE_MAGIC, u32 count, then per item
+//             u32 n, u32 pattern ids[n] (sorted).
+//   error:    u32 ERROR_MAGIC, u32 length, `length` bytes of message, in
+//             place of the response when a SHARED item is unsealed or
+//             shorter than its length. The connection stays usable.
+//
+// A malformed request closes the connection.
+namespace wire {
+
+constexpr uint32_t REQUEST_MAGIC = 0x51415346;   // "FSAQ"
+constexpr uint32_t RESPONSE_MAGIC = 0x52415346;  // "FSAR"
+constexpr uint32_t ERROR_MAGIC = 0x45415346;     // "FSAE"
+constexpr uint32_t INLINE = 0;
+constexpr uint32_t SHARED = 1;
+constexpr uint32_t MAX_BATCH = 4096;
+constexpr uint32_t MAX_SHARED = 64;
+constexpr uint64_t MAX_INLINE = 64u << 20;
+constexpr uint32_t MAX_ERROR = 4096;
+
+struct Item {
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t length;
+};
+
+}
+
+// Serves match requests for one bundle on a Unix domain socket. Each
+// connection gets a thread; the bundle is shared and read-only.
+class MatchServer {
+public:
+    // Binds and listens on `path`, replacing a stale socket file. Throws
+    // std::system_error.
+    MatchServer(const BundleView& bundle, const std::string& path);
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+    ~MatchServer();
+
+    // Accepts connections until stop() is called.
+    void serve();
+    // Safe to call from another thread or a signal-driven watcher.
+    void stop();
+
+private:
+    struct Connection {
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void handle(int fd);
+    // Joins connection threads that have finished.
+    void reap();
+
+    const BundleView& bundle_;
+    std::string path_;
+    int listen_fd_;
+    std::atomic<bool> stopping_{false};
+    std::mutex clients_mutex_;
+    std::vector<int> clients_;
+    std::list<Connection> connections_;
+};
+
+// Client side of the protocol. Buffers of at least `shared_threshold`
+// bytes travel as memfds instead of being copied through the socket.
+class MatchClient {
+public:
+    // Throws std::system_error if the daemon is not reachable.
+    explicit MatchClient(const std::string& path, size_t shared_threshold = 256 << 10);
+    MatchClient(const MatchClient&) = delete;
+    MatchClient& operator=(const MatchClient&) = delete;
+    ~MatchClient();
+
+    // Matches every buffer; result i holds the patterns found in buffers[i].
+    // Large inputs are split into several requests as the protocol limits
+    // require. Throws std::system_error, or std::runtime_error when the
+    // daemon rejects a request or breaks the protocol.
+    std::vector<std::vector<PatternId>> match(const std::vector<std::string_view>& buffers);
+
+private:
+    void batch(const std::vector<std::string_view>& buffers, size_t begin, size_t end,
+               std::vector<std::vector<PatternId>>& results);
+
+    int fd_;
+    size_t shared_threshold_;
+};
+
+}
+
+#endif
@@ -0,0 +1,248 @@
+#include "decompress.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef FSA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FSA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fsa {
+
+Compression detect_compression(std::string_view head){
+    auto starts = [&](std::string_view magic){ return head.substr(0, magic.size()) == magic; };
+    if(starts("\x1f\x8b")) return Compression::Gzip;
+    if(starts("\x28\xb5\x2f\xfd")) return Compression::Zstd;
+    return Compression::None;
+}
+
+bool compression_supported(Compression compression){
+    switch(compression){
+    case Compression::None:
+        return true;
+    case Compression::Gzip:
+#ifdef FSA_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Compression::Zstd:
+#ifdef FSA_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+DecompressedReader::DecompressedReader(const std::string& path, const DecompressOptions& options)
+    : path_(path), chunk_size_(std::max<size_t>(4096, options.chunk_size)){
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd_ < 0) throw std::system_error(errno, std::generic_category(), path);
+    char head[4];
+    ssize_t n = ::pread(fd_, head, sizeof(head), 0);
+    compression_ = detect_compression(std::string_view(head, n > 0 ? static_cast<size_t>(n) : 0));
+    if(!compression_supported(compression_)){
+        ::close(fd_);
+        const char* name = compression_ == Compression::Gzip ? "gzip" : "zstd";
+        throw std::runtime_error(path + ": " + name + " input is not supported by this build");
+    }
+    unsigned depth = std::max(2u, options.queue_depth);
+    chunks_.resize(depth);
+    lengths_.resize(depth);
+    for(unsigned i = 0; i < depth; i++){
+        chunks_[i].resize(chunk_size_);
+        free_.push_back(i);
+    }
+    worker_ = std::thread(&DecompressedReader::produce, this);
+}
+
+DecompressedReader::~DecompressedReader(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    changed_.notify_all();
+    worker_.join();
+    ::close(fd_);
+}
+
+std::string_view DecompressedReader::next(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(current_ >= 0){
+        free_.push_back(static_cast<unsigned>(current_));
+        current_ = -1;
+        changed_.notify_all();
+    }
+    changed_.wait(lock, [this]{ return finished_ || !full_.empty(); });
+    if(full_.empty()){
+        if(error_) std::rethrow_exception(std::exchange(error_, nullptr));
+        return {};
+    }
+    current_ = static_cast<int>(full_.front());
+    full_.pop_front();
+    return {chunks_[current_].data(), lengths_[current_]};
+}
+
+void DecompressedReader::produce(){
+    try{
+        switch(compression_){
+        case Compression::None: decode_plain(); break;
+        case Compression::Gzip: decode_gzip(); break;
+        case Compression::Zstd: decode_zstd(); break;
+        }
+        flush();
+    }catch(...){
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    changed_.notify_all();
+}
+
+size_t DecompressedReader::read_input(char* buffer, size_t size){
+    while(true){
+        ssize_t n = ::read(fd_, buffer, size);
+        if(n >= 0) return static_cast<size_t>(n);
+        if(errno != EINTR) throw std::system_error(errno, std::generic_category(), path_);
+    }
+}
+
+char* DecompressedReader::space(size_t& available){
+    if(filling_ < 0){
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]{ return cancelled_ || !free_.empty(); });
+        if(cancelled_) return nullptr;
+        filling_ = static_cast<int>(free_.front());
+        free_.pop_front();
+        filled_ = 0;
+    }
+    available = chunk_size_ - filled_;
+    return chunks_[filling_].data() + filled_;
+}
+
+void DecompressedReader::commit(size_t length){
+    filled_ += length;
+    if(filled_ == chunk_size_) flush();
+}
+
+void DecompressedReader::flush(){
+    if(filling_ < 0 || filled_ == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lengths_[filling_] = filled_;
+        full_.push_back(static_cast<unsigned>(filling_));
+    }
+    filling_ = -1;
+    changed_.notify_all();
+}
+
+void DecompressedReader::decode_plain(){
+    while(true){
+        size_t available;
+        char* out = space(available);
+        if(!out) return;
+        size_t n = read_input(out, available);
+        if(n == 0) return;
+        commit(n);
+    }
+}
+
+void DecompressedReader::decode_gzip(){
+#ifdef FSA_HAVE_ZLIB
+    z_stream z{};
+    // 32 lets zlib accept both gzip and zlib headers.
+    if(inflateInit2(&z, 15 + 32) != Z_OK) throw std::runtime_error(path_ + ": cannot initialize zlib");
+    std::unique_ptr<z_stream, int (*)(z_stream*)> end(&z, inflateEnd);
+    std::vector<char> in(chunk_size_);
+    bool ended = false;
+    bool drained = true;   // the last call left output space, so holds nothing back
+    while(true){
+        if(z.avail_in == 0 && drained){
+            size_t n = read_input(in.data(), in.size());
+            if(n == 0){
+                if(!ended) throw std::runtime_error(path_ + ": truncated gzip data");
+                return;
+            }
+            z.next_in = reinterpret_cast<Bytef*>(in.data());
+            z.avail_in = static_cast<uInt>(n);
+        }
+        if(ended){
+            // Concatenated members, as written by `cat a.gz b.gz`, each
+            // open with the gzip magic. Anything else after a member, such
+            // as tar or block padding, is ignored the way gzip(1) does.
+            while(z.avail_in < 2){
+                std::memmove(in.data(), z.next_in, z.avail_in);
+                z.next_in = reinterpret_cast<Bytef*>(in.data());
+                size_t n = read_input(in.data() + z.avail_in, in.size() - z.avail_in);
+                if(n == 0) return;
+                z.avail_in += static_cast<uInt>(n);
+            }
+            if(z.next_in[0] != 0x1f || z.next_in[1] != 0x8b) return;
+            inflateReset(&z);
+            ended = false;
+        }
+        size_t available;
+        char* out = space(available);
+        if(!out) return;
+        z.next_out = reinterpret_cast<Bytef*>(out);
+        z.avail_out = static_cast<uInt>(available);
+        int r = inflate(&z, Z_NO_FLUSH);
+        drained = z.avail_out != 0;
+        commit(available - z.avail_out);
+        if(r == Z_STREAM_END){
+            ended = true;
+            drained = true;
+        }else if(r != Z_OK && r != Z_BUF_ERROR){
+            throw std::runtime_error(path_ + ": " + (z.msg ? z.msg : "corrupt gzip data"));
+        }
+    }
+#endif
+}
+
+void DecompressedReader::decode_zstd(){
+#ifdef FSA_HAVE_ZSTD
+    std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> stream(ZSTD_createDStream(), ZSTD_freeDStream);
+    if(!stream) throw std::bad_alloc();
+    ZSTD_initDStream(stream.get());
+    std::vector<char> in(chunk_size_);
+    ZSTD_inBuffer input{in.data(), 0, 0};
+    size_t hint = 1;       // 0 once a frame is complete
+    bool drained = true;
+    while(true){
+        if(input.pos == input.size && drained){
+            size_t n = read_input(in.data(), in.size());
+            if(n == 0){
+                if(hint != 0) throw std::runtime_error(path_ + ": truncated zstd data");
+                return;
+            }
+            input = {in.data(), n, 0};
+        }
+        size_t available;
+        char* out = space(available);
+        if(!out) return;
+        ZSTD_outBuffer output{out, available, 0};
+        hint = ZSTD_decompressStream(stream.get(), &output, &input);
+        if(ZSTD_isError(hint)) throw std::runtime_error(path_ + ": " + ZSTD_getErrorName(hint));
+        drained = output.pos < output.size;
+        commit(output.pos);
+    }
+#endif
+}
+
+}
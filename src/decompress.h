@@ -0,0 +1,103 @@
+#ifndef FSA_DECOMPRESS_H
+#define FSA_DECOMPRESS_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "stream.h"
+
+namespace fsa {
+
+enum class Compression { None, Gzip, Zstd };
+
+// Recognizes the gzip and zstd magic numbers at the start of a file.
+Compression detect_compression(std::string_view head);
+
+// Whether this build can decode the format; None is always supported.
+bool compression_supported(Compression compression);
+
+struct DecompressOptions {
+    // Bytes per decompressed chunk handed to the reader.
+    size_t chunk_size = 1 << 18;
+    // Chunks buffered ahead of the reader; bounds memory use.
+    unsigned queue_depth = 4;
+};
+
+// Reads a file on a background thread, decompressing gzip or zstd input on
+// the fly, and hands out the plain bytes in chunks, so decompression of
+// the next chunk overlaps whatever the caller does with the current one.
+// Uncompressed files pass through unchanged. Throws std::system_error if the
+// file cannot be opened and std::runtime_error for a format this build
+// cannot decode.
+class DecompressedReader {
+public:
+    explicit DecompressedReader(const std::string& path, const DecompressOptions& options = {});
+    DecompressedReader(const DecompressedReader&) = delete;
+    DecompressedReader& operator=(const DecompressedReader&) = delete;
+    // Stops the decoder early if the input was not read to the end.
+    ~DecompressedReader();
+
+    Compression compression() const { return compression_; }
+
+    // The next chunk, valid until the following call; empty at the end of
+    // the input. Rethrows errors from reading or decoding.
+    std::string_view next();
+
+private:
+    // Decoder thread side.
+    void produce();
+    void decode_plain();
+    void decode_gzip();
+    void decode_zstd();
+    size_t read_input(char* buffer, size_t size);
+    // Output space in the chunk being filled; nullptr once cancelled.
+    char* space(size_t& available);
+    void commit(size_t length);
+    void flush();
+
+    int fd_;
+    std::string path_;
+    Compression compression_;
+    size_t chunk_size_;
+    std::vector<std::vector<char>> chunks_;
+    std::vector<size_t> lengths_;
+    int filling_ = -1;
+    size_t filled_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<unsigned> free_;
+    std::deque<unsigned> full_;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    std::exception_ptr error_;
+    int current_ = -1;
+
+    std::thread worker_;
+};
+
+// match_set() over the decompressed contents of a file, scanning each chunk
+// while the next one is being decoded. Stops reading once the result
+// cannot change.
+template <class Automaton>
+std::vector<PatternId> scan_compressed_file(const Automaton& automaton, const std::string& path,
+                                            const DecompressOptions& options = {}){
+    DecompressedReader reader(path, options);
+    StreamMatcher<Automaton> matcher(automaton);
+    while(!matcher.done()){
+        std::string_view chunk = reader.next();
+        if(chunk.empty()) break;
+        matcher.feed(chunk);
+    }
+    return matcher.matches();
+}
+
+}
+
+#endif
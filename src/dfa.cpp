@@ -0,0 +1,357 @@
+#include "dfa.h"
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+
+#include "scan.h"
+
+namespace fsa {
+
+std::vector<uint8_t> ByteClasses::representatives() const {
+    std::vector<uint8_t> reps(count);
+    for(int b = 255; b >= 0; b--) reps[of[b]] = static_cast<uint8_t>(b);
+    return reps;
+}
+
+StateId DFA::add_state(){
+    table_.resize(table_.size() + 256, DEAD);
+    matches_.emplace_back();
+    return static_cast<StateId>(matches_.size() - 1);
+}
+
+void DFA::add_match(StateId state, PatternId pattern){
+    std::vector<PatternId>& list = matches_[state];
+    auto it = std::lower_bound(list.begin(), list.end(), pattern);
+    if(it == list.end() || *it != pattern) list.insert(it, pattern);
+    if(pattern >= patterns_) patterns_ = pattern + 1;
+}
+
+size_t DFA::memory_usage() const {
+    size_t bytes = table_.size() * sizeof(StateId);
+    for(const auto& list : matches_) bytes += sizeof(list) + list.size() * sizeof(PatternId);
+    return bytes;
+}
+
+ByteClasses DFA::byte_classes() const {
+    std::array<uint64_t, 256> hash;
+    hash.fill(0xcbf29ce484222325ull);
+    for(StateId s = 0; s < size(); s++){
+        const StateId* r = row(s);
+        for(int b = 0; b < 256; b++) hash[b] = (hash[b] ^ r[b]) * 0x100000001b3ull;
+    }
+    auto same_column = [this](int a, int b){
+        for(StateId s = 0; s < size(); s++){
+            if(next(s, static_cast<uint8_t>(a)) != next(s, static_cast<uint8_t>(b))) return false;
+        }
+        return true;
+    };
+    ByteClasses classes;
+    classes.count = 0;
+    std::vector<int> first_of_class;
+    for(int b = 0; b < 256; b++){
+        unsigned found = classes.count;
+        for(unsigned c = 0; c < classes.count; c++){
+            int rep = first_of_class[c];
+            if(hash[rep] == hash[b] && same_column(rep, b)){
+                found = c;
+                break;
+            }
+        }
+        if(found == classes.count){
+            first_of_class.push_back(b);
+            classes.count++;
+        }
+        classes.of[b] = static_cast<uint8_t>(found);
+    }
+    return classes;
+}
+
+bool DFA::find(std::string_view text) const {
+    return scan_find(*this, text);
+}
+
+bool DFA::accepts(std::string_view text) const {
+    return scan_accepts(*this, text);
+}
+
+std::vector<PatternId> DFA::match_set(std::string_view text) const {
+    return scan_match_set(*this, text);
+}
+
+MatchLists::MatchLists(const DFA& dfa){
+    begin_.reserve(dfa.size() + 1);
+    begin_.push_back(0);
+    for(StateId s = 0; s < dfa.size(); s++){
+        const std::vector<PatternId>& m = dfa.matches(s);
+        ids_.insert(ids_.end(), m.begin(), m.end());
+        begin_.push_back(static_cast<uint32_t>(ids_.size()));
+    }
+}
+
+size_t MatchLists::memory_usage() const {
+    return begin_.size() * sizeof(uint32_t) + ids_.size() * sizeof(PatternId);
+}
+
+namespace {
+
+// Byte classes implied by the NFA's transition ranges.
+ByteClasses nfa_byte_classes(const NFA& nfa){
+    std::array<bool, 257> boundary{};
+    boundary[0] = true;
+    for(StateId s = 0; s < nfa.size(); s++){
+        for(const NFA::Transition& t : nfa.state(s).transitions){
+            boundary[t.lo] = true;
+            boundary[t.hi + 1] = true;
+        }
+    }
+    ByteClasses classes;
+    int current = -1;
+    for(int b = 0; b < 256; b++){
+        if(boundary[b]) current++;
+        classes.of[b] = static_cast<uint8_t>(current);
+    }
+    classes.count = static_cast<unsigned>(current + 1);
+    return classes;
+}
+
+}
+
+DFA determinize(const NFA& nfa, bool anchored, size_t max_states){
+    if(!anchored && nfa.length_prefixed()){
+        throw std::invalid_argument("length-prefixed groups only compile anchored");
+    }
+    DFA dfa;
+    dfa.set_anchored(anchored);
+    dfa.set_pattern_count(nfa.pattern_count());
+
+    ByteClasses classes = nfa_byte_classes(nfa);
+    std::vector<uint8_t> reps = classes.representatives();
+    std::vector<std::vector<uint8_t>> members(classes.count);
+    for(int b = 0; b < 256; b++) members[classes.of[b]].push_back(static_cast<uint8_t>(b));
+    std::vector<bool> scratch(nfa.size(), false);
+
+    std::vector<StateId> start_set{nfa.start()};
+    nfa.closure(start_set, scratch);
+
+    // Every state of an unanchored DFA contains the start closure, so it
+    // is left out of the set keys, and its moves on each byte class are
+    // computed once instead of on every step.
+    std::vector<bool> in_start(nfa.size(), false);
+    std::vector<std::vector<StateId>> start_moves;
+    if(!anchored){
+        for(StateId s : start_set) in_start[s] = true;
+        start_moves.resize(classes.count);
+        for(unsigned c = 0; c < classes.count; c++){
+            std::vector<StateId>& moved = start_moves[c];
+            for(StateId s : start_set){
+                for(const NFA::Transition& t : nfa.state(s).transitions){
+                    if(t.lo <= reps[c] && reps[c] <= t.hi) moved.push_back(t.to);
+                }
+            }
+            nfa.closure(moved, scratch);
+            moved.erase(std::remove_if(moved.begin(), moved.end(), [&](StateId s){ return in_start[s]; }), moved.end());
+        }
+    }
+
+    std::unordered_map<std::vector<StateId>, StateId, StateSetHash> ids;
+    std::deque<std::vector<StateId>> work;
+
+    auto intern = [&](std::vector<StateId>&& set){
+        auto it = ids.find(set);
+        if(it != ids.end()) return it->second;
+        if(dfa.size() >= max_states) throw StateLimitError(max_states);
+        StateId id = dfa.add_state();
+        for(StateId s : set){
+            PatternId p = nfa.state(s).match;
+            if(p != NFA::NO_MATCH) dfa.add_match(id, p);
+        }
+        if(!anchored){
+            for(StateId s : start_set){
+                PatternId p = nfa.state(s).match;
+                if(p != NFA::NO_MATCH) dfa.add_match(id, p);
+            }
+        }
+        ids.emplace(set, id);
+        work.push_back(std::move(set));
+        return id;
+    };
+
+    dfa.set_start(intern(anchored ? std::vector<StateId>(start_set) : std::vector<StateId>()));
+
+    std::vector<StateId> moved;
+    std::vector<StateId> merged;
+    while(!work.empty()){
+        std::vector<StateId> set = std::move(work.front());
+        work.pop_front();
+        StateId from = ids.at(set);
+        for(unsigned c = 0; c < classes.count; c++){
+            uint8_t byte = reps[c];
+            moved.clear();
+            for(StateId s : set){
+                for(const NFA::Transition& t : nfa.state(s).transitions){
+                    if(t.lo <= byte && byte <= t.hi) moved.push_back(t.to);
+                }
+            }
+            StateId to;
+            if(anchored){
+                if(moved.empty()) continue;
+                nfa.closure(moved, scratch);
+                to = intern(std::vector<StateId>(moved));
+            }else{
+                if(!moved.empty()) nfa.closure(moved, scratch);
+                merged.clear();
+                std::set_union(moved.begin(), moved.end(), start_moves[c].begin(), start_moves[c].end(),
+                               std::back_inserter(merged));
+                merged.erase(std::remove_if(merged.begin(), merged.end(), [&](StateId s){ return in_start[s]; }), merged.end());
+                to = intern(std::vector<StateId>(merged));
+            }
+            for(uint8_t b : members[c]) dfa.set_transition(from, b, to);
+        }
+    }
+    return dfa;
+}
+
+DFA minimize(const DFA& dfa){
+    size_t n = dfa.size();
+    if(n == 0) return dfa;
+    ByteClasses classes = dfa.byte_classes();
+    std::vector<uint8_t> reps = classes.representatives();
+    size_t k = classes.count;
+
+    // Predecessors of every state, grouped by target and sorted by class
+    // within a target. DEAD is the extra state n; its block is never split
+    // and never used as a splitter, so edges into it are not recorded.
+    std::vector<uint32_t> pred_begin(n + 2, 0);
+    for(StateId s = 0; s < n; s++){
+        for(uint8_t byte : reps){
+            StateId t = dfa.next(s, byte);
+            if(t != DFA::DEAD) pred_begin[t + 2]++;
+        }
+    }
+    for(size_t i = 2; i < pred_begin.size(); i++) pred_begin[i] += pred_begin[i - 1];
+    std::vector<uint32_t> pred_from(pred_begin[n + 1]);
+    std::vector<uint8_t> pred_class(pred_begin[n + 1]);
+    for(unsigned c = 0; c < k; c++){
+        for(StateId s = 0; s < n; s++){
+            StateId t = dfa.next(s, reps[c]);
+            if(t == DFA::DEAD) continue;
+            uint32_t at = pred_begin[t + 1]++;
+            pred_from[at] = s;
+            pred_class[at] = static_cast<uint8_t>(c);
+        }
+    }
+
+    // Blocks are contiguous ranges of `elements`. Initial partition: by
+    // match set, with DEAD alone.
+    std::vector<uint32_t> elements(n + 1);
+    std::vector<uint32_t> location(n + 1);
+    std::vector<uint32_t> block(n + 1);
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> last;
+    {
+        std::unordered_map<std::vector<StateId>, uint32_t, StateSetHash> by_matches;
+        for(StateId s = 0; s < n; s++){
+            const std::vector<PatternId>& m = dfa.matches(s);
+            auto it = by_matches.emplace(std::vector<StateId>(m.begin(), m.end()), static_cast<uint32_t>(by_matches.size())).first;
+            block[s] = it->second;
+        }
+        size_t initial = by_matches.size();
+        block[n] = static_cast<uint32_t>(initial);
+        std::vector<uint32_t> fill(initial + 2, 0);
+        for(uint32_t s = 0; s <= n; s++) fill[block[s] + 1]++;
+        for(size_t b = 1; b < fill.size(); b++) fill[b] += fill[b - 1];
+        first.assign(fill.begin(), fill.end() - 1);
+        last.assign(fill.begin() + 1, fill.end());
+        for(uint32_t s = 0; s <= n; s++){
+            location[s] = fill[block[s]]++;
+            elements[location[s]] = s;
+        }
+    }
+    uint32_t dead_block = block[n];
+
+    // Hopcroft refinement: split every block by which of its states enter
+    // the splitter on a class. Splitting keeps the runtime near
+    // O(k n log n) where Moore's rounds grow with the longest chain.
+    std::vector<uint32_t> marked(first.size(), 0);
+    std::vector<bool> queued(first.size() * k, false);
+    std::vector<std::pair<uint32_t, unsigned>> work;
+    for(uint32_t b = 0; b < first.size(); b++){
+        if(b == dead_block) continue;
+        for(unsigned c = 0; c < k; c++){
+            queued[b * k + c] = true;
+            work.push_back({b, c});
+        }
+    }
+    std::vector<uint32_t> splitter;
+    std::vector<uint32_t> touched;
+    while(!work.empty()){
+        auto [b, c] = work.back();
+        work.pop_back();
+        queued[b * k + c] = false;
+        splitter.assign(elements.begin() + first[b], elements.begin() + last[b]);
+        for(uint32_t t : splitter){
+            const uint8_t* lo = pred_class.data() + pred_begin[t];
+            const uint8_t* hi = pred_class.data() + pred_begin[t + 1];
+            const uint8_t* from = std::lower_bound(lo, hi, static_cast<uint8_t>(c));
+            for(; from != hi && *from == c; from++){
+                uint32_t s = pred_from[static_cast<size_t>(from - pred_class.data())];
+                uint32_t y = block[s];
+                uint32_t to = first[y] + marked[y];
+                if(location[s] < to) continue;
+                if(marked[y] == 0) touched.push_back(y);
+                uint32_t other = elements[to];
+                elements[to] = s;
+                elements[location[s]] = other;
+                location[other] = location[s];
+                location[s] = to;
+                marked[y]++;
+            }
+        }
+        for(uint32_t y : touched){
+            uint32_t count = marked[y];
+            marked[y] = 0;
+            if(count == last[y] - first[y]) continue;
+            uint32_t z = static_cast<uint32_t>(first.size());
+            first.push_back(first[y]);
+            last.push_back(first[y] + count);
+            marked.push_back(0);
+            first[y] += count;
+            for(uint32_t i = first[z]; i < last[z]; i++) block[elements[i]] = z;
+            queued.resize(first.size() * k, false);
+            bool z_smaller = last[z] - first[z] <= last[y] - first[y];
+            for(unsigned a = 0; a < k; a++){
+                uint32_t add = queued[y * k + a] || z_smaller ? z : y;
+                if(queued[add * k + a]) continue;
+                queued[add * k + a] = true;
+                work.push_back({add, a});
+            }
+        }
+        touched.clear();
+    }
+
+    // Number the blocks by their first state, as the states were ordered.
+    std::vector<StateId> id(first.size(), DFA::DEAD);
+    DFA result;
+    result.set_anchored(dfa.anchored());
+    result.set_pattern_count(dfa.pattern_count());
+    std::vector<StateId> representative;
+    for(StateId s = 0; s < n; s++){
+        if(id[block[s]] != DFA::DEAD) continue;
+        id[block[s]] = result.add_state();
+        representative.push_back(s);
+    }
+    for(StateId to = 0; to < representative.size(); to++){
+        StateId s = representative[to];
+        for(int b = 0; b < 256; b++){
+            StateId t = dfa.next(s, static_cast<uint8_t>(b));
+            result.set_transition(to, static_cast<uint8_t>(b), t == DFA::DEAD ? DFA::DEAD : id[block[t]]);
+        }
+        for(PatternId p : dfa.matches(s)) result.add_match(to, p);
+    }
+    result.set_start(dfa.start() == DFA::DEAD ? DFA::DEAD : id[block[dfa.start()]]);
+    return result;
+}
+
+}
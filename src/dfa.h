@@ -0,0 +1,122 @@
+#ifndef FSA_DFA_H
+#define FSA_DFA_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "nfa.h"
+
+namespace fsa {
+
+// Thrown when determinization would produce more states than allowed.
+class StateLimitError : public std::runtime_error {
+public:
+    explicit StateLimitError(size_t limit)
+        : std::runtime_error("DFA exceeds " + std::to_string(limit) + " states"), limit_(limit){}
+    size_t limit() const { return limit_; }
+private:
+    size_t limit_;
+};
+
+// Maps every byte to its equivalence class: bytes in one class take the same
+// transition out of every state.
+struct ByteClasses {
+    std::array<uint8_t, 256> of{};
+    unsigned count = 1;
+
+    // Smallest byte in each class, indexed by class.
+    std::vector<uint8_t> representatives() const;
+};
+
+// Dense DFA: one row of 256 next-state entries per state. Missing
+// transitions lead to DEAD, which is not a real state.
+class DFA {
+public:
+    static constexpr StateId DEAD = UINT32_MAX;
+
+    StateId add_state();
+    void set_transition(StateId from, uint8_t byte, StateId to){ table_[index(from, byte)] = to; }
+    StateId next(StateId from, uint8_t byte) const { return table_[index(from, byte)]; }
+    const StateId* row(StateId state) const { return &table_[index(state, 0)]; }
+
+    StateId start() const { return start_; }
+    void set_start(StateId state){ start_ = state; }
+
+    // Unanchored DFAs restart the pattern at every input position, so they
+    // report matches ending anywhere; anchored ones only match prefixes.
+    bool anchored() const { return anchored_; }
+    void set_anchored(bool anchored){ anchored_ = anchored; }
+
+    void add_match(StateId state, PatternId pattern);
+    const std::vector<PatternId>& matches(StateId state) const { return matches_[state]; }
+    bool accepting(StateId state) const { return !matches_[state].empty(); }
+
+    size_t size() const { return matches_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    void set_pattern_count(size_t count){ patterns_ = count; }
+
+    // Bytes used by the transition table and match lists.
+    size_t memory_usage() const;
+
+    ByteClasses byte_classes() const;
+
+    // True if the input, or a prefix of it, reaches an accepting state.
+    bool find(std::string_view text) const;
+    // True if the whole input ends in an accepting state.
+    bool accepts(std::string_view text) const;
+    // Every pattern whose accepting state is reached while scanning, sorted.
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    size_t index(StateId state, uint8_t byte) const { return static_cast<size_t>(state) * 256 + byte; }
+
+    std::vector<StateId> table_;
+    std::vector<std::vector<PatternId>> matches_;
+    StateId start_ = DEAD;
+    bool anchored_ = true;
+    size_t patterns_ = 0;
+};
+
+// Match sets of every state of a DFA in two flat arrays, for the compact
+// representations where a vector per state would dominate memory.
+class MatchLists {
+public:
+    struct Range {
+        const PatternId* first;
+        const PatternId* last;
+        const PatternId* begin() const { return first; }
+        const PatternId* end() const { return last; }
+        bool empty() const { return first == last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    MatchLists() = default;
+    explicit MatchLists(const DFA& dfa);
+
+    Range operator[](StateId state) const {
+        return {ids_.data() + begin_[state], ids_.data() + begin_[state + 1]};
+    }
+    bool accepting(StateId state) const { return begin_[state] != begin_[state + 1]; }
+    size_t memory_usage() const;
+
+private:
+    std::vector<uint32_t> begin_;
+    std::vector<PatternId> ids_;
+};
+
+constexpr size_t DEFAULT_STATE_LIMIT = 1 << 20;
+
+// Subset construction. Throws StateLimitError past `max_states`, and
+// std::invalid_argument for an unanchored NFA with length-prefixed groups.
+DFA determinize(const NFA& nfa, bool anchored, size_t max_states = DEFAULT_STATE_LIMIT);
+
+// Merges equivalent states (Hopcroft partition refinement). States with
+// different match sets are never merged.
+DFA minimize(const DFA& dfa);
+
+}
+
+#endif
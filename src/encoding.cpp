@@ -0,0 +1,83 @@
+#include "encoding.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace fsa {
+
+namespace {
+
+constexpr uint64_t LOW_BITS = 0x0101010101010101ull;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+uint64_t load(const unsigned char* p){
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// Nonzero if any byte of the word is zero.
+uint64_t has_zero(uint64_t word){
+    return (word - LOW_BITS) & ~word & HIGH_BITS;
+}
+
+bool has_nul(const unsigned char* p, size_t n){
+    return std::memchr(p, 0, n) != nullptr;
+}
+
+// Length of the UTF-8 sequence at p, or 0 if it is invalid. Sequences cut
+// off by `end` are accepted as long as what is there could be valid.
+size_t utf8_sequence(const unsigned char* p, const unsigned char* end){
+    unsigned char c = p[0];
+    size_t length;
+    unsigned char lo = 0x80, hi = 0xbf;   // range of the second byte
+    if(c >= 0xc2 && c <= 0xdf){
+        length = 2;
+    }else if(c >= 0xe0 && c <= 0xef){
+        length = 3;
+        if(c == 0xe0) lo = 0xa0;          // overlong
+        if(c == 0xed) hi = 0x9f;          // surrogates
+    }else if(c >= 0xf0 && c <= 0xf4){
+        length = 4;
+        if(c == 0xf0) lo = 0x90;          // overlong
+        if(c == 0xf4) hi = 0x8f;          // above U+10FFFF
+    }else{
+        return 0;
+    }
+    size_t available = static_cast<size_t>(end - p);
+    if(available > 1 && (p[1] < lo || p[1] > hi)) return 0;
+    for(size_t i = 2; i < length && i < available; i++){
+        if((p[i] & 0xc0) != 0x80) return 0;
+    }
+    return length < available ? length : available;
+}
+
+}
+
+Encoding detect_encoding(std::string_view block){
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(block.data());
+    const unsigned char* end = p + block.size();
+    bool multibyte = false;
+    while(p < end){
+        if(end - p >= 8){
+            uint64_t word = load(p);
+            if(!(word & HIGH_BITS)){
+                if(has_zero(word)) return Encoding::Binary;
+                p += 8;
+                continue;
+            }
+        }
+        if(*p < 0x80){
+            if(*p == 0) return Encoding::Binary;
+            p++;
+            continue;
+        }
+        size_t length = utf8_sequence(p, end);
+        if(length == 0) return has_nul(p, static_cast<size_t>(end - p)) ? Encoding::Binary : Encoding::Bytes;
+        multibyte = true;
+        p += length;
+    }
+    return multibyte ? Encoding::Utf8 : Encoding::Ascii;
+}
+
+}
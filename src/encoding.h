@@ -0,0 +1,26 @@
+#ifndef FSA_ENCODING_H
+#define FSA_ENCODING_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace fsa {
+
+enum class Encoding {
+    Ascii,    // every byte below 0x80
+    Utf8,     // valid UTF-8 with multibyte sequences
+    Bytes,    // text that is not UTF-8, such as Latin-1; scanned as bytes
+    Binary,   // contains a NUL byte
+};
+
+// How much of a file detect_encoding() is meant to look at.
+constexpr size_t ENCODING_PROBE = 1 << 16;
+
+// Classifies the start of a file. A multibyte sequence cut off by the end
+// of the block does not count as invalid. Works eight bytes at a time
+// through ASCII runs, which are most of any text file.
+Encoding detect_encoding(std::string_view block);
+
+}
+
+#endif
@@ -0,0 +1,225 @@
+#include "fm_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "compile.h"
+
+namespace fsa {
+
+namespace {
+
+// Suffix array of text plus a sentinel smaller than every byte, by prefix
+// doubling over cyclic shifts with counting sorts. The sentinel is unique,
+// so sorting the shifts sorts the suffixes.
+std::vector<uint32_t> suffix_array(std::string_view text){
+    uint32_t n = static_cast<uint32_t>(text.size() + 1);
+    auto symbol = [&](uint32_t i) -> uint32_t {
+        return i + 1 == n ? 0 : static_cast<unsigned char>(text[i]) + 1u;
+    };
+    std::vector<uint32_t> sa(n), cls(n), shifted(n), next_cls(n);
+    std::vector<uint32_t> count(std::max<uint32_t>(n, 257), 0);
+    for(uint32_t i = 0; i < n; i++) count[symbol(i)]++;
+    for(size_t c = 1; c < 257; c++) count[c] += count[c - 1];
+    for(uint32_t i = n; i-- > 0;) sa[--count[symbol(i)]] = i;
+    uint32_t classes = 1;
+    cls[sa[0]] = 0;
+    for(uint32_t i = 1; i < n; i++){
+        if(symbol(sa[i]) != symbol(sa[i - 1])) classes++;
+        cls[sa[i]] = classes - 1;
+    }
+    for(uint32_t h = 1; h < n && classes < n; h <<= 1){
+        // Sorted by the second half already; stable sort by the first.
+        for(uint32_t i = 0; i < n; i++) shifted[i] = sa[i] >= h ? sa[i] - h : sa[i] + n - h;
+        std::fill(count.begin(), count.begin() + classes, 0);
+        for(uint32_t i = 0; i < n; i++) count[cls[shifted[i]]]++;
+        for(uint32_t c = 1; c < classes; c++) count[c] += count[c - 1];
+        for(uint32_t i = n; i-- > 0;) sa[--count[cls[shifted[i]]]] = shifted[i];
+        auto second = [&](uint32_t i){ return cls[i + h < n ? i + h : i + h - n]; };
+        classes = 1;
+        next_cls[sa[0]] = 0;
+        for(uint32_t i = 1; i < n; i++){
+            if(cls[sa[i]] != cls[sa[i - 1]] || second(sa[i]) != second(sa[i - 1])) classes++;
+            next_cls[sa[i]] = classes - 1;
+        }
+        cls.swap(next_cls);
+    }
+    return sa;
+}
+
+struct SearchKey {
+    uint32_t lo;
+    uint32_t hi;
+    StateId state;
+    bool operator==(const SearchKey& other) const {
+        return lo == other.lo && hi == other.hi && state == other.state;
+    }
+};
+
+struct SearchKeyHash {
+    size_t operator()(const SearchKey& key) const {
+        uint64_t h = (static_cast<uint64_t>(key.lo) << 32 | key.hi) * 0x9e3779b97f4a7c15ull;
+        return static_cast<size_t>((h ^ key.state) * 0xff51afd7ed558ccdull >> 16);
+    }
+};
+
+}
+
+FMIndex::FMIndex(std::string_view text, const FMIndexOptions& options){
+    if(text.size() >= (size_t{1} << 31) - 1) throw std::length_error("FM-index corpus too large");
+    if(options.sample_rate == 0) throw std::invalid_argument("FM-index sample rate must be positive");
+    std::vector<uint32_t> sa = suffix_array(text);
+    uint32_t n = static_cast<uint32_t>(sa.size());
+
+    std::array<uint32_t, 256> histogram{};
+    for(unsigned char c : text) histogram[c]++;
+    code_.fill(NO_CODE);
+    uint32_t row = 1;
+    for(int b = 0; b < 256; b++){
+        first_[b] = row;
+        row += histogram[b];
+        if(histogram[b] == 0) continue;
+        code_[b] = static_cast<uint16_t>(symbols_.size());
+        symbols_.push_back(static_cast<uint8_t>(b));
+    }
+
+    bwt_.resize(n);
+    for(uint32_t i = 0; i < n; i++){
+        if(sa[i] == 0){
+            bwt_[i] = 0;
+            sentinel_row_ = i;
+        }else{
+            bwt_[i] = static_cast<uint8_t>(text[sa[i] - 1]);
+        }
+    }
+
+    size_t sigma = symbols_.size();
+    size_t blocks = n / FM_BLOCK + 1;
+    ranks_.assign(blocks * sigma, 0);
+    std::vector<uint32_t> running(sigma, 0);
+    for(uint32_t i = 0; i < n; i++){
+        if(i % FM_BLOCK == 0) std::copy(running.begin(), running.end(), ranks_.begin() + (i / FM_BLOCK) * sigma);
+        if(i != sentinel_row_) running[code_[bwt_[i]]]++;
+    }
+    if(n % FM_BLOCK == 0) std::copy(running.begin(), running.end(), ranks_.begin() + (n / FM_BLOCK) * sigma);
+
+    sampled_.assign(n / 64 + 1, 0);
+    for(uint32_t i = 0; i < n; i++){
+        if(sa[i] % options.sample_rate != 0) continue;
+        sampled_[i / 64] |= uint64_t{1} << (i % 64);
+        samples_.push_back(sa[i]);
+    }
+    sampled_rank_.resize(sampled_.size());
+    uint32_t total = 0;
+    for(size_t w = 0; w < sampled_.size(); w++){
+        sampled_rank_[w] = total;
+        total += static_cast<uint32_t>(__builtin_popcountll(sampled_[w]));
+    }
+}
+
+uint32_t FMIndex::occ(uint8_t byte, uint32_t row) const {
+    uint32_t block = row / FM_BLOCK;
+    uint32_t base = block * FM_BLOCK;
+    const uint8_t* first = bwt_.data() + base;
+    uint32_t result = ranks_[block * symbols_.size() + code_[byte]]
+                    + static_cast<uint32_t>(std::count(first, bwt_.data() + row, byte));
+    if(byte == 0 && sentinel_row_ >= base && sentinel_row_ < row) result--;
+    return result;
+}
+
+size_t FMIndex::locate_row(uint32_t row) const {
+    size_t steps = 0;
+    while(!(sampled_[row / 64] >> (row % 64) & 1)){
+        row = extend(bwt_[row], row);
+        steps++;
+    }
+    uint64_t below = sampled_[row / 64] & ((uint64_t{1} << (row % 64)) - 1);
+    return samples_[sampled_rank_[row / 64] + static_cast<uint32_t>(__builtin_popcountll(below))] + steps;
+}
+
+size_t FMIndex::count(std::string_view pattern) const {
+    uint32_t lo = 0;
+    uint32_t hi = static_cast<uint32_t>(bwt_.size());
+    for(size_t i = pattern.size(); i-- > 0 && lo < hi;){
+        uint8_t c = static_cast<uint8_t>(pattern[i]);
+        if(code_[c] == NO_CODE) return 0;
+        lo = extend(c, lo);
+        hi = extend(c, hi);
+    }
+    return hi - lo;
+}
+
+std::vector<size_t> FMIndex::locate(std::string_view pattern, size_t limit) const {
+    uint32_t lo = 0;
+    uint32_t hi = static_cast<uint32_t>(bwt_.size());
+    for(size_t i = pattern.size(); i-- > 0 && lo < hi;){
+        uint8_t c = static_cast<uint8_t>(pattern[i]);
+        if(code_[c] == NO_CODE) return {};
+        lo = extend(c, lo);
+        hi = extend(c, hi);
+    }
+    std::vector<size_t> positions;
+    for(uint32_t r = lo; r < hi && positions.size() < limit; r++) positions.push_back(locate_row(r));
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+std::vector<FMMatch> FMIndex::search(const DFA& reversed, size_t limit) const {
+    std::vector<FMMatch> found;
+    if(reversed.start() == DFA::DEAD || limit == 0) return found;
+    // Depth-first over (suffix range, DFA state), one frame per byte
+    // prepended. What lies to the left of a range depends only on its rows,
+    // so a (range, state) pair without matches below it never has any.
+    struct Frame {
+        uint32_t lo;
+        uint32_t hi;
+        StateId state;
+        uint32_t length;
+        uint32_t symbol;
+        bool fruitful;
+    };
+    std::unordered_set<SearchKey, SearchKeyHash> fruitless;
+    std::vector<Frame> stack{{0, static_cast<uint32_t>(bwt_.size()), reversed.start(), 0, 0, false}};
+    while(!stack.empty()){
+        Frame& top = stack.back();
+        if(top.symbol == symbols_.size() || found.size() == limit){
+            if(!top.fruitful) fruitless.insert({top.lo, top.hi, top.state});
+            bool fruitful = top.fruitful;
+            stack.pop_back();
+            if(!stack.empty()) stack.back().fruitful |= fruitful;
+            continue;
+        }
+        uint8_t c = symbols_[top.symbol++];
+        StateId t = reversed.next(top.state, c);
+        if(t == DFA::DEAD) continue;
+        uint32_t lo = extend(c, top.lo);
+        uint32_t hi = extend(c, top.hi);
+        if(lo == hi || fruitless.count({lo, hi, t})) continue;
+        uint32_t length = top.length + 1;
+        bool accepting = reversed.accepting(t);
+        if(accepting){
+            for(uint32_t r = lo; r < hi && found.size() < limit; r++) found.push_back({locate_row(r), length});
+        }
+        stack.push_back({lo, hi, t, length, 0, accepting});
+    }
+    std::sort(found.begin(), found.end(), [](const FMMatch& a, const FMMatch& b){
+        return a.position != b.position ? a.position < b.position : a.length < b.length;
+    });
+    return found;
+}
+
+std::vector<FMMatch> FMIndex::search(std::string_view pattern, size_t limit) const {
+    NFA nfa;
+    nfa.add(reversed(parse(pattern)));
+    CompileOptions options;
+    options.anchored = true;
+    return search(compile(nfa, options), limit);
+}
+
+size_t FMIndex::memory_usage() const {
+    return bwt_.size() + ranks_.size() * sizeof(uint32_t) + sampled_.size() * sizeof(uint64_t)
+         + sampled_rank_.size() * sizeof(uint32_t) + samples_.size() * sizeof(uint32_t);
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef FSA_FM_INDEX_H
+#define FSA_FM_INDEX_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+struct FMIndexOptions {
+    // Text positions that are a multiple of this keep their suffix array
+    // entry; locating any other occurrence takes up to this many LF steps.
+    uint32_t sample_rate = 32;
+};
+
+// One occurrence of a regex match in the corpus.
+struct FMMatch {
+    size_t position;
+    size_t length;
+};
+
+// FM-index of a corpus: its Burrows-Wheeler transform, rank checkpoints
+// every FM_BLOCK rows for the bytes that occur, and a sampled suffix array.
+// Backward search counts a pattern in time proportional to its length, not
+// the corpus. The corpus must be shorter than 2^31 bytes.
+class FMIndex {
+public:
+    static constexpr uint32_t FM_BLOCK = 128;
+
+    explicit FMIndex(std::string_view text, const FMIndexOptions& options = {});
+
+    size_t count(std::string_view pattern) const;
+    // Start of up to `limit` occurrences of the pattern, sorted.
+    std::vector<size_t> locate(std::string_view pattern, size_t limit = SIZE_MAX) const;
+
+    // Up to `limit` occurrences of non-empty substrings a regex matches,
+    // sorted by position, then length. `reversed` is the anchored DFA of
+    // the reversed regex (see reversed() in regex.h): backward search
+    // extends matches to the left, so the DFA reads them back to front.
+    // Branches where the DFA dies or the range empties are pruned, and
+    // states whose extensions were already found to hold no match are
+    // remembered, so selective patterns touch a small part of the index.
+    std::vector<FMMatch> search(const DFA& reversed, size_t limit = 1000) const;
+    // Parses and reverses the pattern, then searches as above.
+    std::vector<FMMatch> search(std::string_view pattern, size_t limit = 1000) const;
+
+    size_t size() const { return bwt_.size() - 1; }
+    size_t memory_usage() const;
+
+private:
+    static constexpr uint16_t NO_CODE = UINT16_MAX;
+
+    // Rows of the BWT before `row` holding `byte`, which must occur.
+    uint32_t occ(uint8_t byte, uint32_t row) const;
+    // Narrows the rows of a suffix range to those preceded by `byte`.
+    uint32_t extend(uint8_t byte, uint32_t row) const { return first_[byte] + occ(byte, row); }
+    size_t locate_row(uint32_t row) const;
+
+    std::vector<uint8_t> bwt_;            // the sentinel's row holds 0
+    uint32_t sentinel_row_ = 0;
+    std::array<uint16_t, 256> code_;      // byte -> index into symbols_
+    std::vector<uint8_t> symbols_;        // bytes that occur, ascending
+    std::array<uint32_t, 256> first_{};   // first row starting with each byte
+    std::vector<uint32_t> ranks_;         // per block, per symbol
+    std::vector<uint64_t> sampled_;       // rows with a stored position
+    std::vector<uint32_t> sampled_rank_;  // sampled rows before each word
+    std::vector<uint32_t> samples_;
+};
+
+}
+
+#endif
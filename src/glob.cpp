@@ -0,0 +1,228 @@
+#include "glob.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "compile.h"
+
+namespace fsa {
+
+namespace {
+
+ByteSet single(unsigned char c){
+    ByteSet set;
+    set.set(c);
+    return set;
+}
+
+ByteSet not_slash(){
+    ByteSet set;
+    set.set();
+    set.reset('/');
+    return set;
+}
+
+Regex any_run(){
+    ByteSet all;
+    all.set();
+    return Regex::repeat(Regex::byte_set(all), 0, Regex::UNBOUNDED);
+}
+
+class GlobParser {
+public:
+    GlobParser(std::string_view glob, const GlobOptions& options) : g_(glob), options_(options){}
+
+    Regex run(){
+        return sequence(false);
+    }
+
+private:
+    std::string_view g_;
+    GlobOptions options_;
+    size_t pos_ = 0;
+
+    Regex sequence(bool in_braces){
+        std::vector<Regex> parts;
+        while(!done() && !(in_braces && (peek() == ',' || peek() == '}'))) parts.push_back(element());
+        return Regex::concat(std::move(parts));
+    }
+
+    Regex braces(){
+        size_t start = pos_;
+        pos_++;
+        std::vector<Regex> alternatives;
+        depth_++;
+        while(true){
+            alternatives.push_back(sequence(true));
+            if(done()) throw ParseError("unclosed '{'", start);
+            if(peek() == '}') break;
+            pos_++; // ','
+        }
+        pos_++; // '}'
+        depth_--;
+        return Regex::alternate(std::move(alternatives));
+    }
+
+    bool done() const { return pos_ >= g_.size(); }
+    char peek() const { return g_[pos_]; }
+
+    int depth_ = 0;   // braces open around pos_
+
+    // Path components also begin and end at the edges of brace
+    // alternatives, so "{**/a,b}" and "{a/**,b}" work as expected.
+    bool component_start() const {
+        if(pos_ == 0 || g_[pos_ - 1] == '/') return true;
+        return depth_ > 0 && (g_[pos_ - 1] == '{' || g_[pos_ - 1] == ',');
+    }
+
+    bool component_end(size_t i) const {
+        if(i == g_.size()) return true;
+        return depth_ > 0 && (g_[i] == ',' || g_[i] == '}');
+    }
+
+    Regex element(){
+        size_t start = pos_;
+        char c = peek();
+        switch(c){
+        case '*':
+            if(g_.substr(pos_, 2) == "**" && component_start()){
+                if(component_end(pos_ + 2)){
+                    pos_ += 2;
+                    return any_run();
+                }
+                if(g_[pos_ + 2] == '/'){
+                    // "**/": zero or more whole components.
+                    pos_ += 3;
+                    return Regex::repeat(Regex::concat({any_run(), Regex::byte_set(single('/'))}), 0, 1);
+                }
+            }
+            while(!done() && peek() == '*') pos_++;
+            return Regex::repeat(Regex::byte_set(not_slash()), 0, Regex::UNBOUNDED);
+        case '?':
+            pos_++;
+            return Regex::byte_set(not_slash());
+        case '[':
+            return Regex::byte_set(byte_class());
+        case '{':
+            if(!options_.braces) break;
+            return braces();
+        case '\\':
+            pos_++;
+            if(done()) throw ParseError("trailing backslash", start);
+            return Regex::byte_set(single(static_cast<unsigned char>(g_[pos_++])));
+        default:
+            break;
+        }
+        pos_++;
+        return Regex::byte_set(single(static_cast<unsigned char>(c)));
+    }
+
+    unsigned char class_byte(size_t start){
+        if(done()) throw ParseError("unclosed '['", start);
+        if(peek() == '\\'){
+            pos_++;
+            if(done()) throw ParseError("unclosed '['", start);
+        }
+        return static_cast<unsigned char>(g_[pos_++]);
+    }
+
+    ByteSet byte_class(){
+        size_t start = pos_;
+        pos_++;
+        bool negated = false;
+        if(!done() && (peek() == '!' || peek() == '^')){
+            negated = true;
+            pos_++;
+        }
+        ByteSet set;
+        bool first = true;
+        while(true){
+            if(done()) throw ParseError("unclosed '['", start);
+            if(peek() == ']' && !first) break;
+            first = false;
+            unsigned char lo = class_byte(start);
+            if(pos_ + 1 < g_.size() && peek() == '-' && g_[pos_ + 1] != ']'){
+                size_t dash = pos_;
+                pos_++;
+                unsigned char hi = class_byte(start);
+                if(hi < lo) throw ParseError("class range out of order", dash);
+                for(int b = lo; b <= hi; b++) set.set(b);
+            }else{
+                set.set(lo);
+            }
+        }
+        pos_++; // ']'
+        if(negated) set.flip();
+        set.reset('/');
+        return set;
+    }
+};
+
+}
+
+Regex parse_glob(std::string_view glob, const GlobOptions& options){
+    return GlobParser(glob, options).run();
+}
+
+GlobSet::GlobSet(const std::vector<std::string>& globs, const GlobSetOptions& options) : size_(globs.size()){
+    std::vector<Regex> parsed;
+    parsed.reserve(globs.size());
+    for(const std::string& glob : globs) parsed.push_back(parse_glob(glob, options.glob));
+    std::vector<PatternId> ids(globs.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    if(!ids.empty()) build(parsed, std::move(ids), options.max_group_states);
+}
+
+void GlobSet::build(const std::vector<Regex>& globs, std::vector<PatternId> ids, size_t max_states){
+    NFA nfa;
+    for(PatternId id : ids) nfa.add(globs[id]);
+    CompileOptions options;
+    options.anchored = true;
+    options.max_states = max_states;
+    try{
+        dfas_.push_back(compile(nfa, options));
+        groups_.push_back(std::move(ids));
+    }catch(const StateLimitError&){
+        if(ids.size() == 1) throw;
+        std::vector<PatternId> second(ids.begin() + static_cast<std::ptrdiff_t>(ids.size() / 2), ids.end());
+        ids.resize(ids.size() / 2);
+        build(globs, std::move(ids), max_states);
+        build(globs, std::move(second), max_states);
+    }
+}
+
+StateId GlobSet::run(const DFA& dfa, std::string_view path){
+    StateId s = dfa.start();
+    for(unsigned char c : path){
+        if(s == DFA::DEAD) break;
+        s = dfa.next(s, c);
+    }
+    return s;
+}
+
+std::vector<PatternId> GlobSet::matches(std::string_view path) const {
+    std::vector<PatternId> found;
+    for(size_t k = 0; k < dfas_.size(); k++){
+        StateId s = run(dfas_[k], path);
+        if(s == DFA::DEAD) continue;
+        for(PatternId local : dfas_[k].matches(s)) found.push_back(groups_[k][local]);
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+bool GlobSet::is_match(std::string_view path) const {
+    for(const DFA& dfa : dfas_){
+        StateId s = run(dfa, path);
+        if(s != DFA::DEAD && dfa.accepting(s)) return true;
+    }
+    return false;
+}
+
+size_t GlobSet::total_states() const {
+    size_t total = 0;
+    for(const DFA& dfa : dfas_) total += dfa.size();
+    return total;
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef FSA_GLOB_H
+#define FSA_GLOB_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+#include "regex.h"
+
+namespace fsa {
+
+// Parses a path glob into the regex syntax tree, so globs compile through
+// the same NFA and DFA pipeline as regexes. The glob must match a whole
+// path, so compile it anchored and test the state the path ends in.
+//
+//   *      any run of bytes other than '/'
+//   ?      one byte other than '/'
+//   [...]  one byte from the class ([!...] or [^...] negates); never '/'
+//   **     any run of bytes, '/' included, when it is a whole path
+//          component: "**/x" matches x at any depth, "a/**" everything
+//          under a, "a/**/b" b anywhere below a. Elsewhere it acts as *.
+//   {a,b}  any of the comma-separated alternatives, which may nest and
+//          contain wildcards (unless GlobOptions::braces is off)
+//   \c     the byte c itself
+//
+// Throws ParseError for an unclosed class or brace or a trailing backslash.
+struct GlobOptions {
+    // .gitignore rules take '{' literally.
+    bool braces = true;
+};
+
+Regex parse_glob(std::string_view glob, const GlobOptions& options = {});
+
+struct GlobSetOptions {
+    GlobOptions glob;
+    // Globs are compiled together into as few anchored DFAs as fit this
+    // many states; a group that would not fit is split in half.
+    size_t max_group_states = 10000;
+};
+
+// Many globs tested against a path in one pass per DFA group, instead of
+// one glob after another. Glob i reports PatternId i.
+class GlobSet {
+public:
+    explicit GlobSet(const std::vector<std::string>& globs, const GlobSetOptions& options = {});
+
+    // Every glob matching the whole path, sorted.
+    std::vector<PatternId> matches(std::string_view path) const;
+    // True if any glob matches; stops at the first group that matches.
+    bool is_match(std::string_view path) const;
+
+    size_t size() const { return size_; }
+    size_t group_count() const { return dfas_.size(); }
+    size_t total_states() const;
+
+private:
+    void build(const std::vector<Regex>& globs, std::vector<PatternId> ids, size_t max_states);
+    // State the path ends in, or DEAD.
+    static StateId run(const DFA& dfa, std::string_view path);
+
+    std::vector<DFA> dfas_;
+    std::vector<std::vector<PatternId>> groups_;   // local id -> glob id
+    size_t size_ = 0;
+};
+
+}
+
+#endif
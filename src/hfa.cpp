@@ -0,0 +1,138 @@
+#include "hfa.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fsa {
+
+bool split_at_wide_repeat(const Regex& regex, Regex& head, Regex& tail){
+    if(regex.kind != Regex::Kind::Concat) return false;
+    const std::vector<Regex>& parts = regex.children;
+    size_t first = 0;
+    while(first < parts.size() && is_wide_repeat(parts[first]) && parts[first].min == 0) first++;
+    for(size_t i = first + 1; i < parts.size(); i++){
+        if(!is_wide_repeat(parts[i])) continue;
+        head = Regex::concat(std::vector<Regex>(parts.begin() + first, parts.begin() + i));
+        tail = Regex::concat(std::vector<Regex>(parts.begin() + i, parts.end()));
+        return true;
+    }
+    return false;
+}
+
+HFA::HFA(const std::vector<std::string>& patterns, const CompileOptions& options)
+    : patterns_(patterns.size()){
+    if(options.anchored) throw std::invalid_argument("HFA only supports unanchored search");
+    NFA head_nfa;
+    for(size_t i = 0; i < patterns.size(); i++){
+        PatternId id = static_cast<PatternId>(i);
+        Regex regex = parse(patterns[i]);
+        Regex head, tail;
+        if(split_at_wide_repeat(regex, head, tail)){
+            head_nfa.add(head);
+            head_matches_.push_back({id, tails_.size()});
+            tails_.push_back({id, NFA()});
+            tails_.back().nfa.add(tail);
+        }else{
+            head_nfa.add(regex);
+            head_matches_.push_back({id, NO_TAIL});
+        }
+    }
+    head_ = compile(head_nfa, options);
+}
+
+size_t HFA::memory_usage() const {
+    size_t bytes = head_.memory_usage() + head_matches_.size() * sizeof(HeadMatch);
+    for(const Tail& t : tails_){
+        for(StateId s = 0; s < t.nfa.size(); s++){
+            const NFA::State& state = t.nfa.state(s);
+            bytes += sizeof(state) + state.transitions.size() * sizeof(NFA::Transition)
+                + state.epsilon.size() * sizeof(StateId);
+        }
+    }
+    return bytes;
+}
+
+std::vector<PatternId> HFA::match_set(std::string_view text) const {
+    std::vector<bool> found(patterns_, false);
+    size_t remaining = patterns_;
+    auto report = [&](PatternId p){
+        if(!found[p]){
+            found[p] = true;
+            remaining--;
+        }
+    };
+
+    // Active tails with their current NFA state sets.
+    std::vector<std::vector<StateId>> current(tails_.size());
+    std::vector<std::vector<bool>> scratch(tails_.size());
+    std::vector<size_t> active;
+    std::vector<bool> is_active(tails_.size(), false);
+    std::vector<StateId> moved;
+
+    auto accepts = [this](size_t tail, const std::vector<StateId>& set){
+        const NFA& nfa = tails_[tail].nfa;
+        for(StateId s : set){
+            if(nfa.state(s).match != NFA::NO_MATCH) return true;
+        }
+        return false;
+    };
+    auto activate = [&](size_t tail){
+        if(found[tails_[tail].pattern]) return;
+        const NFA& nfa = tails_[tail].nfa;
+        if(scratch[tail].empty()) scratch[tail].assign(nfa.size(), false);
+        current[tail].push_back(nfa.start());
+        nfa.closure(current[tail], scratch[tail]);
+        if(!is_active[tail]){
+            is_active[tail] = true;
+            active.push_back(tail);
+        }
+        if(accepts(tail, current[tail])) report(tails_[tail].pattern);
+    };
+    auto on_head = [&](StateId s){
+        for(PatternId id : head_.matches(s)){
+            const HeadMatch& m = head_matches_[id];
+            if(m.tail == NO_TAIL) report(m.pattern);
+            else activate(m.tail);
+        }
+    };
+
+    StateId s = head_.start();
+    if(s == DFA::DEAD) return {};
+    on_head(s);
+    for(unsigned char c : text){
+        if(remaining == 0) break;
+        // Tails step first: a head match ending here activates its tail at
+        // the following byte.
+        for(size_t i = 0; i < active.size();){
+            size_t tail = active[i];
+            const NFA& nfa = tails_[tail].nfa;
+            moved.clear();
+            for(StateId t : current[tail]){
+                for(const NFA::Transition& tr : nfa.state(t).transitions){
+                    if(tr.lo <= c && c <= tr.hi) moved.push_back(tr.to);
+                }
+            }
+            nfa.closure(moved, scratch[tail]);
+            current[tail].swap(moved);
+            if(accepts(tail, current[tail])) report(tails_[tail].pattern);
+            if(current[tail].empty() || found[tails_[tail].pattern]){
+                current[tail].clear();
+                is_active[tail] = false;
+                active[i] = active.back();
+                active.pop_back();
+            }else{
+                i++;
+            }
+        }
+        s = head_.next(s, c);
+        if(head_.accepting(s)) on_head(s);
+    }
+
+    std::vector<PatternId> result;
+    for(PatternId p = 0; p < patterns_; p++){
+        if(found[p]) result.push_back(p);
+    }
+    return result;
+}
+
+}
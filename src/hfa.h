@@ -0,0 +1,64 @@
+#ifndef FSA_HFA_H
+#define FSA_HFA_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compile.h"
+#include "dfa.h"
+#include "nfa.h"
+
+namespace fsa {
+
+// Splits a pattern at its first unbounded repeat of a wide byte set (`.*`,
+// `[^\n]+`, ...) that follows a non-empty prefix. Returns false, leaving
+// `head` and `tail` untouched, if the pattern has no such repeat. Leading
+// wide repeats are dropped first: in an unanchored search they never
+// change whether a pattern matches.
+bool split_at_wide_repeat(const Regex& regex, Regex& head, Regex& tail);
+
+// Hybrid finite automaton for unanchored multi-pattern search. Patterns
+// without a wide repeat, and the heads of those with one, share one DFA;
+// the remainder of each split pattern is a small tail NFA that the head
+// activates when the head part matches. Taking the `.*` parts out of the
+// head keeps `A.*B` rules from multiplying each other's states, while the
+// input is still scanned once.
+class HFA {
+public:
+    // Pattern i reports PatternId i. Only unanchored search is supported;
+    // throws std::invalid_argument if options.anchored is set.
+    explicit HFA(const std::vector<std::string>& patterns, const CompileOptions& options = {});
+
+    const DFA& head() const { return head_; }
+    size_t tail_count() const { return tails_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    size_t memory_usage() const;
+
+    // Every pattern that matches somewhere in `text`, sorted.
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    struct Tail {
+        PatternId pattern;
+        NFA nfa;
+    };
+
+    // What a head DFA match id stands for: a whole pattern, or the head of
+    // tails_[tail].
+    struct HeadMatch {
+        PatternId pattern;
+        size_t tail;
+    };
+
+    static constexpr size_t NO_TAIL = SIZE_MAX;
+
+    DFA head_;
+    std::vector<HeadMatch> head_matches_;
+    std::vector<Tail> tails_;
+    size_t patterns_;
+};
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "hybrid.h"
+
+#include <stdexcept>
+
+#include "scan.h"
+
+namespace fsa {
+
+HybridDFA::HybridDFA(const DFA& dfa, const HybridOptions& options)
+    : classes_(dfa.byte_classes()), matches_(dfa), start_(dfa.start()),
+      anchored_(dfa.anchored()), patterns_(dfa.pattern_count()){
+    std::vector<bool> force_dense(dfa.size(), false);
+    for(StateId s : options.dense_states){
+        if(s < dfa.size()) force_dense[s] = true;
+    }
+    std::vector<uint8_t> reps = classes_.representatives();
+    std::vector<uint8_t> ends;
+    std::vector<StateId> targets;
+    index_.reserve(dfa.size());
+    for(StateId s = 0; s < dfa.size(); s++){
+        const StateId* row = dfa.row(s);
+        ends.clear();
+        targets.clear();
+        for(int b = 0; b < 256; b++){
+            if(b == 255 || row[b + 1] != row[b]){
+                ends.push_back(static_cast<uint8_t>(b));
+                targets.push_back(row[b]);
+            }
+        }
+        if(data_.size() > OFFSET_MASK) throw std::length_error("hybrid DFA table too large");
+        uint32_t offset = static_cast<uint32_t>(data_.size());
+        if(force_dense[s] || ends.size() > options.max_sparse_ranges){
+            index_.push_back(offset);
+            for(uint8_t rep : reps) data_.push_back(row[rep]);
+            dense_++;
+            continue;
+        }
+        index_.push_back(offset | SPARSE);
+        uint32_t count = static_cast<uint32_t>(ends.size());
+        data_.push_back(count);
+        size_t packed = data_.size();
+        data_.resize(packed + (count + 3) / 4, 0);
+        uint8_t* packed_ends = reinterpret_cast<uint8_t*>(data_.data() + packed);
+        for(uint32_t i = 0; i < count; i++) packed_ends[i] = ends[i];
+        data_.insert(data_.end(), targets.begin(), targets.end());
+    }
+}
+
+size_t HybridDFA::memory_usage() const {
+    return sizeof(classes_.of) + index_.size() * sizeof(uint32_t) + data_.size() * sizeof(uint32_t)
+        + matches_.memory_usage();
+}
+
+bool HybridDFA::find(std::string_view text) const {
+    return scan_find(*this, text);
+}
+
+bool HybridDFA::accepts(std::string_view text) const {
+    return scan_accepts(*this, text);
+}
+
+std::vector<PatternId> HybridDFA::match_set(std::string_view text) const {
+    return scan_match_set(*this, text);
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef FSA_HYBRID_H
+#define FSA_HYBRID_H
+
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+struct HybridOptions {
+    // States whose transitions split into more byte ranges than this get a
+    // dense row; the rest are stored as sorted ranges.
+    unsigned max_sparse_ranges = 4;
+    // States that get a dense row whatever their fan-out, typically
+    // Profile::hot_states(dfa, coverage) for the same DFA.
+    std::vector<StateId> dense_states;
+};
+
+// Read-only DFA storing each state either as a dense row indexed by byte
+// class or as a short list of byte ranges, chosen per state. Both kinds
+// live in one word array; the per-state entry holds the offset with the
+// kind in its top bit. State ids are the same as in the source DFA.
+class HybridDFA {
+public:
+    static constexpr StateId DEAD = DFA::DEAD;
+
+    explicit HybridDFA(const DFA& dfa, const HybridOptions& options = {});
+
+    StateId next(StateId state, uint8_t byte) const {
+        uint32_t entry = index_[state];
+        const uint32_t* data = data_.data() + (entry & OFFSET_MASK);
+        if(!(entry & SPARSE)) return data[classes_.of[byte]];
+        // Sparse: count, range ends packed four to a word, then targets.
+        uint32_t count = data[0];
+        const uint8_t* ends = reinterpret_cast<const uint8_t*>(data + 1);
+        uint32_t i = 0;
+        while(ends[i] < byte) i++;
+        return data[1 + (count + 3) / 4 + i];
+    }
+
+    StateId start() const { return start_; }
+    bool anchored() const { return anchored_; }
+    bool accepting(StateId state) const { return matches_.accepting(state); }
+    MatchLists::Range matches(StateId state) const { return matches_[state]; }
+    size_t size() const { return index_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    size_t dense_count() const { return dense_; }
+    size_t memory_usage() const;
+
+    bool find(std::string_view text) const;
+    bool accepts(std::string_view text) const;
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    static constexpr uint32_t SPARSE = 1u << 31;
+    static constexpr uint32_t OFFSET_MASK = SPARSE - 1;
+
+    ByteClasses classes_;
+    std::vector<uint32_t> index_;
+    std::vector<uint32_t> data_;
+    MatchLists matches_;
+    StateId start_;
+    bool anchored_;
+    size_t patterns_;
+    size_t dense_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include "layout.h"
+
+#include <algorithm>
+#include <deque>
+
+namespace fsa {
+
+std::vector<StateId> bfs_order(const DFA& dfa){
+    std::vector<StateId> order;
+    order.reserve(dfa.size());
+    std::vector<bool> seen(dfa.size(), false);
+    std::deque<StateId> queue;
+    if(dfa.start() != DFA::DEAD){
+        seen[dfa.start()] = true;
+        queue.push_back(dfa.start());
+    }
+    while(!queue.empty()){
+        StateId s = queue.front();
+        queue.pop_front();
+        order.push_back(s);
+        const StateId* row = dfa.row(s);
+        for(int b = 0; b < 256; b++){
+            StateId t = row[b];
+            if(t != DFA::DEAD && !seen[t]){
+                seen[t] = true;
+                queue.push_back(t);
+            }
+        }
+    }
+    for(StateId s = 0; s < dfa.size(); s++){
+        if(!seen[s]) order.push_back(s);
+    }
+    return order;
+}
+
+std::vector<uint64_t> visit_counts(const DFA& dfa, std::string_view sample){
+    std::vector<uint64_t> visits(dfa.size(), 0);
+    StateId s = dfa.start();
+    if(s == DFA::DEAD) return visits;
+    visits[s]++;
+    for(unsigned char c : sample){
+        s = dfa.next(s, c);
+        if(s == DFA::DEAD) break;
+        visits[s]++;
+    }
+    return visits;
+}
+
+std::vector<StateId> hot_order(const DFA& dfa, const std::vector<uint64_t>& weight){
+    std::vector<StateId> order = bfs_order(dfa);
+    std::stable_sort(order.begin(), order.end(), [&](StateId a, StateId b){
+        uint64_t wa = a < weight.size() ? weight[a] : 0;
+        uint64_t wb = b < weight.size() ? weight[b] : 0;
+        return wa > wb;
+    });
+    return order;
+}
+
+DFA renumber(const DFA& dfa, const std::vector<StateId>& order){
+    std::vector<StateId> new_id(dfa.size(), DFA::DEAD);
+    for(size_t i = 0; i < order.size(); i++) new_id[order[i]] = static_cast<StateId>(i);
+
+    DFA result;
+    result.set_anchored(dfa.anchored());
+    result.set_pattern_count(dfa.pattern_count());
+    for(size_t i = 0; i < order.size(); i++) result.add_state();
+    for(size_t i = 0; i < order.size(); i++){
+        StateId to = static_cast<StateId>(i);
+        const StateId* row = dfa.row(order[i]);
+        for(int b = 0; b < 256; b++){
+            StateId t = row[b];
+            result.set_transition(to, static_cast<uint8_t>(b), t == DFA::DEAD ? DFA::DEAD : new_id[t]);
+        }
+        for(PatternId p : dfa.matches(order[i])) result.add_match(to, p);
+    }
+    result.set_start(dfa.start() == DFA::DEAD ? DFA::DEAD : new_id[dfa.start()]);
+    return result;
+}
+
+}
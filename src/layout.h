@@ -0,0 +1,33 @@
+#ifndef FSA_LAYOUT_H
+#define FSA_LAYOUT_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// State orders are permutations: order[i] is the old id of the state that
+// renumber() places at position i.
+
+// Breadth-first from the start state, visiting successors in byte order.
+// States unreachable from the start keep their relative order at the end.
+std::vector<StateId> bfs_order(const DFA& dfa);
+
+// How many times each state is entered while scanning `sample`, counting
+// the start state once per scan.
+std::vector<uint64_t> visit_counts(const DFA& dfa, std::string_view sample);
+
+// States with nonzero weight first, heaviest first; everything else follows
+// in breadth-first order. Ties between equally hot states also fall back to
+// breadth-first order, which keeps the result deterministic.
+std::vector<StateId> hot_order(const DFA& dfa, const std::vector<uint64_t>& weight);
+
+// Returns a copy of `dfa` with state order[i] renamed to i.
+DFA renumber(const DFA& dfa, const std::vector<StateId>& order);
+
+}
+
+#endif
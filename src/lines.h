@@ -0,0 +1,114 @@
+#ifndef FSA_LINES_H
+#define FSA_LINES_H
+
+#include <cstring>
+#include <string_view>
+
+#include "scan.h"
+
+namespace fsa {
+
+// Line-oriented matching: a line matches when some pattern matches inside
+// it, with the newline excluded. Newlines are located with memchr and
+// memrchr, which are vectorized in the C library, and only around
+// candidate matches; the automaton itself never tests for '\n'.
+
+namespace detail {
+
+inline size_t next_newline(std::string_view text, size_t from){
+    if(from >= text.size()) return text.size();
+    const void* p = std::memchr(text.data() + from, '\n', text.size() - from);
+    return p ? static_cast<size_t>(static_cast<const char*>(p) - text.data()) : text.size();
+}
+
+inline size_t line_start(std::string_view text, size_t from, size_t at){
+    if(at <= from) return from;
+    const void* p = ::memrchr(text.data() + from, '\n', at - from);
+    return p ? static_cast<size_t>(static_cast<const char*>(p) - text.data()) + 1 : from;
+}
+
+}
+
+// Lines in the text; a final line without '\n' counts.
+inline size_t count_lines(std::string_view text){
+    size_t lines = 0;
+    for(size_t i = 0; i < text.size(); i = detail::next_newline(text, i) + 1) lines++;
+    return lines;
+}
+
+// Calls on_line(begin, end) for every matching line, in order, where
+// [begin, end) excludes the newline; returns how many there were.
+//
+// An unanchored automaton runs across line boundaries. Its state is then
+// a superset of the one a restart at the line start would give, so it
+// never misses a match but may report one that spans lines. Each candidate
+// is confirmed by rescanning its line alone, and the scan restarts after
+// that line. Anchored automata restart at every line.
+template <class Automaton, class OnLine>
+size_t scan_lines(const Automaton& a, std::string_view text, OnLine&& on_line){
+    size_t found = 0;
+    const size_t n = text.size();
+    if(a.start() == Automaton::DEAD) return 0;
+    if(a.anchored()){
+        for(size_t begin = 0; begin < n;){
+            size_t end = detail::next_newline(text, begin);
+            if(scan_find(a, text.substr(begin, end - begin))){
+                on_line(begin, end);
+                found++;
+            }
+            begin = end + 1;
+        }
+        return found;
+    }
+    size_t line = 0;   // every match before this has been reported
+    while(line < n){
+        StateId s = a.start();
+        size_t i = line;
+        bool hit = a.accepting(s);
+        while(!hit && i < n){
+            s = a.next(s, static_cast<unsigned char>(text[i++]));
+            if(s == Automaton::DEAD) break;
+            hit = a.accepting(s);
+        }
+        if(!hit){
+            if(i >= n) break;
+            line = detail::next_newline(text, i - 1) + 1;   // died: restart on the next line
+            continue;
+        }
+        // The candidate ends on byte i - 1, or is empty at `line`.
+        size_t last = i > line ? i - 1 : line;
+        size_t begin = detail::line_start(text, line, last);
+        size_t end = detail::next_newline(text, last);
+        if(scan_find(a, text.substr(begin, end - begin))){
+            on_line(begin, end);
+            found++;
+        }
+        line = end + 1;
+    }
+    return found;
+}
+
+// Calls on_line(begin, end) for every line without a match.
+template <class Automaton, class OnLine>
+size_t scan_lines_inverted(const Automaton& a, std::string_view text, OnLine&& on_line){
+    size_t found = 0;
+    size_t next = 0;   // start of the first line not yet visited
+    auto gap = [&](size_t until){
+        while(next < until){
+            size_t end = detail::next_newline(text, next);
+            on_line(next, end);
+            found++;
+            next = end + 1;
+        }
+    };
+    scan_lines(a, text, [&](size_t begin, size_t end){
+        gap(begin);
+        next = end + 1;
+    });
+    gap(text.size());
+    return found;
+}
+
+}
+
+#endif
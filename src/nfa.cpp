@@ -0,0 +1,140 @@
+#include "nfa.h"
+
+#include <algorithm>
+
+namespace fsa {
+
+NFA::NFA(){
+    start_ = add_state();
+}
+
+StateId NFA::add_state(){
+    states_.emplace_back();
+    return static_cast<StateId>(states_.size() - 1);
+}
+
+void NFA::add_transition(StateId from, uint8_t lo, uint8_t hi, StateId to){
+    states_[from].transitions.push_back({lo, hi, to});
+}
+
+void NFA::add_epsilon(StateId from, StateId to){
+    states_[from].epsilon.push_back(to);
+}
+
+PatternId NFA::add(const Regex& regex){
+    PatternId id = static_cast<PatternId>(patterns_++);
+    length_prefixed_ |= has_length_prefix(regex);
+    StateId first = static_cast<StateId>(states_.size());
+    Fragment f = build(regex);
+    add_epsilon(start_, f.in);
+    set_match(f.out, id);
+    ranges_.emplace_back(first, static_cast<StateId>(states_.size()));
+    return id;
+}
+
+void NFA::detach(PatternId pattern){
+    std::vector<StateId>& edges = states_[start_].epsilon;
+    StateId first = ranges_[pattern].first;
+    StateId last = ranges_[pattern].second;
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [&](StateId t){
+        return t >= first && t < last;
+    }), edges.end());
+}
+
+NFA::Fragment NFA::build(const Regex& regex){
+    switch(regex.kind){
+    case Regex::Kind::Empty: {
+        StateId s = add_state();
+        return {s, s};
+    }
+    case Regex::Kind::Bytes: {
+        StateId in = add_state();
+        StateId out = add_state();
+        int c = 0;
+        while(c < 256){
+            if(!regex.bytes.test(c)){ c++; continue; }
+            int lo = c;
+            while(c < 256 && regex.bytes.test(c)) c++;
+            add_transition(in, static_cast<uint8_t>(lo), static_cast<uint8_t>(c - 1), out);
+        }
+        return {in, out};
+    }
+    case Regex::Kind::Concat: {
+        Fragment whole = build(regex.children[0]);
+        for(size_t i = 1; i < regex.children.size(); i++){
+            Fragment next = build(regex.children[i]);
+            add_epsilon(whole.out, next.in);
+            whole.out = next.out;
+        }
+        return whole;
+    }
+    case Regex::Kind::Alternate: {
+        StateId in = add_state();
+        StateId out = add_state();
+        for(const Regex& child : regex.children){
+            Fragment f = build(child);
+            add_epsilon(in, f.in);
+            add_epsilon(f.out, out);
+        }
+        return {in, out};
+    }
+    case Regex::Kind::Repeat: {
+        const Regex& child = regex.children[0];
+        StateId in = add_state();
+        StateId cur = in;
+        for(int i = 0; i < regex.min; i++){
+            Fragment f = build(child);
+            add_epsilon(cur, f.in);
+            cur = f.out;
+        }
+        StateId out = add_state();
+        if(regex.max == Regex::UNBOUNDED){
+            Fragment f = build(child);
+            add_epsilon(cur, f.in);
+            add_epsilon(f.out, cur);
+            add_epsilon(cur, out);
+        }else{
+            for(int i = regex.min; i < regex.max; i++){
+                add_epsilon(cur, out);
+                Fragment f = build(child);
+                add_epsilon(cur, f.in);
+                cur = f.out;
+            }
+            add_epsilon(cur, out);
+        }
+        return {in, out};
+    }
+    }
+    return {start_, start_};
+}
+
+void NFA::closure(std::vector<StateId>& seeds) const {
+    std::vector<bool> scratch(states_.size(), false);
+    closure(seeds, scratch);
+}
+
+void NFA::closure(std::vector<StateId>& seeds, std::vector<bool>& seen) const {
+    std::vector<StateId> stack;
+    for(StateId s : seeds){
+        if(!seen[s]){
+            seen[s] = true;
+            stack.push_back(s);
+        }
+    }
+    seeds.clear();
+    while(!stack.empty()){
+        StateId s = stack.back();
+        stack.pop_back();
+        seeds.push_back(s);
+        for(StateId t : states_[s].epsilon){
+            if(!seen[t]){
+                seen[t] = true;
+                stack.push_back(t);
+            }
+        }
+    }
+    for(StateId s : seeds) seen[s] = false;
+    std::sort(seeds.begin(), seeds.end());
+}
+
+}
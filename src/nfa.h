@@ -0,0 +1,93 @@
+#ifndef FSA_NFA_H
+#define FSA_NFA_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "regex.h"
+
+namespace fsa {
+
+using StateId = uint32_t;
+using PatternId = uint32_t;
+
+// Hash for sets of NFA states kept as sorted vectors.
+struct StateSetHash {
+    size_t operator()(const std::vector<StateId>& v) const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for(StateId s : v) h = (h ^ s) * 0x100000001b3ull;
+        return static_cast<size_t>(h);
+    }
+};
+
+// Thompson NFA over bytes. Several patterns can share one NFA; each
+// pattern's accepting state carries its PatternId.
+class NFA {
+public:
+    static constexpr PatternId NO_MATCH = UINT32_MAX;
+
+    struct Transition {
+        uint8_t lo;
+        uint8_t hi;
+        StateId to;
+    };
+
+    struct State {
+        std::vector<Transition> transitions;
+        std::vector<StateId> epsilon;
+        PatternId match = NO_MATCH;
+    };
+
+    NFA();
+
+    // Adds a pattern reachable from start(). Returns its PatternId, which is
+    // the number of patterns added before it.
+    PatternId add(const Regex& regex);
+    PatternId add(std::string_view pattern){ return add(parse(pattern)); }
+
+    StateId add_state();
+    void add_transition(StateId from, uint8_t lo, uint8_t hi, StateId to);
+    void add_epsilon(StateId from, StateId to);
+    void set_match(StateId state, PatternId pattern){ states_[state].match = pattern; }
+
+    StateId start() const { return start_; }
+    const State& state(StateId id) const { return states_[id]; }
+    size_t size() const { return states_.size(); }
+    size_t pattern_count() const { return patterns_; }
+    // True once a pattern with a length-prefixed group has been added.
+    bool length_prefixed() const { return length_prefixed_; }
+
+    // States built for `pattern`, as the half-open range [first, second).
+    // Patterns never share states, and their edges stay inside the range.
+    std::pair<StateId, StateId> pattern_states(PatternId pattern) const { return ranges_[pattern]; }
+    // Removes the epsilon edge from start() to `pattern`. Its states stay
+    // allocated but can no longer be reached.
+    void detach(PatternId pattern);
+
+    // Adds the states reachable from `seeds` by epsilon moves to `seeds`,
+    // leaving the result sorted and free of duplicates. `scratch` must hold
+    // size() false entries and is left that way, so callers computing many
+    // closures can reuse one buffer.
+    void closure(std::vector<StateId>& seeds, std::vector<bool>& scratch) const;
+    void closure(std::vector<StateId>& seeds) const;
+
+private:
+    struct Fragment {
+        StateId in;
+        StateId out;
+    };
+
+    Fragment build(const Regex& regex);
+
+    std::vector<State> states_;
+    StateId start_;
+    size_t patterns_ = 0;
+    bool length_prefixed_ = false;
+    std::vector<std::pair<StateId, StateId>> ranges_;
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "partition.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace fsa {
+
+size_t Partition::total_states() const {
+    size_t total = 0;
+    for(const DFA& dfa : dfas) total += dfa.size();
+    return total;
+}
+
+std::vector<PatternId> Partition::match_set(std::string_view text) const {
+    std::vector<PatternId> found;
+    for(size_t k = 0; k < dfas.size(); k++){
+        for(PatternId local : dfas[k].match_set(text)) found.push_back(groups[k][local]);
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+namespace {
+
+// Compiles the patterns listed in `ids` into `out`; false if they exceed
+// the state limit.
+bool try_compile(const std::vector<std::string>& patterns, const std::vector<PatternId>& ids,
+                 const CompileOptions& options, DFA& out){
+    std::vector<std::string> group;
+    group.reserve(ids.size());
+    for(PatternId id : ids) group.push_back(patterns[id]);
+    try{
+        out = compile(group, options);
+        return true;
+    }catch(const StateLimitError&){
+        return false;
+    }
+}
+
+}
+
+Partition partition_patterns(const std::vector<std::string>& patterns, const PartitionOptions& options){
+    CompileOptions compile_options = options.compile;
+    compile_options.max_states = options.max_group_states;
+    size_t n = patterns.size();
+
+    std::vector<size_t> alone(n);
+    for(PatternId i = 0; i < n; i++){
+        DFA dfa;
+        if(!try_compile(patterns, {i}, compile_options, dfa)) throw StateLimitError(options.max_group_states);
+        alone[i] = dfa.size();
+    }
+
+    // interaction[i][j]: states the pair needs beyond its parts, or the
+    // budget itself when the pair does not fit at all.
+    std::vector<std::vector<size_t>> interaction;
+    if(n <= options.max_probe_patterns){
+        interaction.assign(n, std::vector<size_t>(n, 0));
+        for(PatternId i = 0; i < n; i++){
+            for(PatternId j = i + 1; j < n; j++){
+                DFA pair;
+                size_t cost = options.max_group_states;
+                if(try_compile(patterns, {i, j}, compile_options, pair)){
+                    size_t parts = alone[i] + alone[j];
+                    cost = pair.size() > parts ? pair.size() - parts : 0;
+                }
+                interaction[i][j] = interaction[j][i] = cost;
+            }
+        }
+    }
+
+    std::vector<PatternId> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&alone](PatternId a, PatternId b){
+        return alone[a] > alone[b];
+    });
+
+    Partition result;
+    result.pattern_count = n;
+    std::vector<size_t> candidates;
+    for(PatternId p : order){
+        candidates.resize(result.groups.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+        if(!interaction.empty()){
+            std::vector<size_t> cost(result.groups.size(), 0);
+            for(size_t k = 0; k < result.groups.size(); k++){
+                for(PatternId q : result.groups[k]) cost[k] += interaction[p][q];
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [&cost](size_t a, size_t b){
+                return cost[a] < cost[b];
+            });
+        }
+        bool placed = false;
+        for(size_t k : candidates){
+            std::vector<PatternId> ids = result.groups[k];
+            ids.push_back(p);
+            DFA dfa;
+            if(try_compile(patterns, ids, compile_options, dfa)){
+                result.groups[k] = std::move(ids);
+                result.dfas[k] = std::move(dfa);
+                placed = true;
+                break;
+            }
+        }
+        if(!placed){
+            result.groups.push_back({p});
+            DFA dfa;
+            try_compile(patterns, {p}, compile_options, dfa);
+            result.dfas.push_back(std::move(dfa));
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef FSA_PARTITION_H
+#define FSA_PARTITION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compile.h"
+#include "dfa.h"
+
+namespace fsa {
+
+struct PartitionOptions {
+    // No group's combined DFA may have more states than this.
+    size_t max_group_states = 10000;
+    // Pairwise interaction probes cost one compile per pair, so they only
+    // run for rule sets up to this size; larger sets are packed in order.
+    size_t max_probe_patterns = 256;
+    // Applied to every group; max_states is replaced by max_group_states.
+    CompileOptions compile;
+};
+
+// Rule set split into groups that each compile to one bounded DFA.
+struct Partition {
+    // groups[k] lists the patterns in dfas[k]; local id i of dfas[k] is
+    // pattern groups[k][i].
+    std::vector<std::vector<PatternId>> groups;
+    std::vector<DFA> dfas;
+    size_t pattern_count = 0;
+
+    size_t total_states() const;
+    // Every pattern matching in `text`, sorted, using one pass per group.
+    std::vector<PatternId> match_set(std::string_view text) const;
+};
+
+// Packs patterns into as few groups as the state budget allows. Each
+// pattern is compiled alone, then pairwise with every other pattern: the
+// states a pair needs beyond its two parts estimate how badly they
+// interact. Patterns are placed largest first into the existing group they
+// interact with least that still compiles within the budget, or into a new
+// group. Throws StateLimitError if a single pattern exceeds the budget.
+Partition partition_patterns(const std::vector<std::string>& patterns, const PartitionOptions& options = {});
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "layout.h"
+
+namespace fsa {
+
+uint64_t fingerprint(const DFA& dfa){
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](uint64_t v){ h = (h ^ v) * 0x100000001b3ull; };
+    mix(dfa.size());
+    mix(dfa.start());
+    mix(dfa.anchored());
+    for(StateId s = 0; s < dfa.size(); s++){
+        const StateId* row = dfa.row(s);
+        for(int b = 0; b < 256; b++) mix(row[b]);
+        for(PatternId p : dfa.matches(s)) mix(p);
+        mix(UINT64_MAX);
+    }
+    return h;
+}
+
+Profile::Profile(const DFA& dfa)
+    : fingerprint_(fsa::fingerprint(dfa)), visits_(dfa.size(), 0), counts_(dfa.size()){}
+
+bool Profile::fits(const DFA& dfa) const {
+    return dfa.size() == visits_.size() && fsa::fingerprint(dfa) == fingerprint_;
+}
+
+Profile::Row& Profile::row(StateId state){
+    if(!counts_[state]){
+        counts_[state] = std::make_unique<Row>();
+        counts_[state]->fill(0);
+    }
+    return *counts_[state];
+}
+
+void Profile::train(const DFA& dfa, std::string_view sample){
+    if(!fits(dfa)) throw std::invalid_argument("profile was recorded on a different DFA");
+    StateId s = dfa.start();
+    if(s == DFA::DEAD) return;
+    visits_[s]++;
+    for(unsigned char c : sample){
+        row(s)[c]++;
+        s = dfa.next(s, c);
+        if(s == DFA::DEAD) return;
+        visits_[s]++;
+    }
+}
+
+uint64_t Profile::transitions(StateId state, uint8_t byte) const {
+    return counts_[state] ? (*counts_[state])[byte] : 0;
+}
+
+uint64_t Profile::total() const {
+    return std::accumulate(visits_.begin(), visits_.end(), uint64_t{0});
+}
+
+std::vector<StateId> Profile::hot_states(double coverage) const {
+    std::vector<StateId> states;
+    for(StateId s = 0; s < visits_.size(); s++){
+        if(visits_[s] > 0) states.push_back(s);
+    }
+    std::stable_sort(states.begin(), states.end(), [this](StateId a, StateId b){
+        return visits_[a] > visits_[b];
+    });
+    double goal = coverage * static_cast<double>(total());
+    double covered = 0;
+    size_t keep = 0;
+    while(keep < states.size() && covered < goal){
+        covered += static_cast<double>(visits_[states[keep]]);
+        keep++;
+    }
+    states.resize(keep);
+    return states;
+}
+
+std::vector<StateId> Profile::hot_states(const DFA& dfa, double coverage) const {
+    std::vector<StateId> hot = hot_states(coverage);
+    if(fits(dfa)) return hot;
+    if(dfa.size() != visits_.size()) throw std::invalid_argument("profile was recorded on a different DFA");
+    // compile() applies hot_order() to a DFA already in breadth-first
+    // order, so profiled state order[i] became state i. Undoing that
+    // permutation must give back the profiled DFA exactly.
+    std::vector<StateId> order(visits_.size());
+    std::iota(order.begin(), order.end(), StateId{0});
+    std::stable_sort(order.begin(), order.end(), [this](StateId a, StateId b){
+        return visits_[a] > visits_[b];
+    });
+    std::vector<StateId> new_id(order.size());
+    for(size_t i = 0; i < order.size(); i++) new_id[order[i]] = static_cast<StateId>(i);
+    if(!fits(renumber(dfa, new_id))) throw std::invalid_argument("profile was recorded on a different DFA");
+    for(StateId& s : hot) s = new_id[s];
+    return hot;
+}
+
+void Profile::save(std::ostream& out) const {
+    out << "fsa-profile 1\n";
+    out << "states " << visits_.size() << " fingerprint " << std::hex << fingerprint_ << std::dec << "\n";
+    for(StateId s = 0; s < visits_.size(); s++){
+        if(visits_[s] == 0) continue;
+        out << "v " << s << " " << visits_[s] << "\n";
+        if(!counts_[s]) continue;
+        for(int b = 0; b < 256; b++){
+            uint64_t n = (*counts_[s])[b];
+            if(n != 0) out << "t " << s << " " << b << " " << n << "\n";
+        }
+    }
+}
+
+Profile Profile::load(std::istream& in, size_t max_states){
+    auto fail = [](){ throw std::runtime_error("malformed DFA profile"); };
+    std::string word;
+    int version = 0;
+    if(!(in >> word >> version) || word != "fsa-profile" || version != 1) fail();
+    size_t states = 0;
+    std::string fingerprint_word;
+    Profile profile;
+    if(!(in >> word >> states >> fingerprint_word >> std::hex >> profile.fingerprint_ >> std::dec)) fail();
+    if(word != "states" || fingerprint_word != "fingerprint") fail();
+    if(states > max_states) fail();
+    profile.visits_.assign(states, 0);
+    profile.counts_.resize(states);
+    while(in >> word){
+        StateId s = 0;
+        if(word == "v"){
+            uint64_t n = 0;
+            if(!(in >> s >> n) || s >= states) fail();
+            profile.visits_[s] = n;
+        }else if(word == "t"){
+            int b = 0;
+            uint64_t n = 0;
+            if(!(in >> s >> b >> n) || s >= states || b < 0 || b > 255) fail();
+            profile.row(s)[b] = n;
+        }else{
+            fail();
+        }
+    }
+    return profile;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef FSA_PROFILE_H
+#define FSA_PROFILE_H
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// Identifies a DFA's exact table, match sets and start state. Profiles
+// only apply to the DFA they were recorded on.
+uint64_t fingerprint(const DFA& dfa);
+
+// Transition counts recorded by scanning sample input. Record a profile
+// against the DFA compile() returns without a profile; compiling again
+// with the profile then reorders states hottest first (see CompileOptions).
+class Profile {
+public:
+    Profile() = default;
+    explicit Profile(const DFA& dfa);
+
+    // Scans `sample` from the start state, counting each transition taken.
+    // Throws std::invalid_argument if `dfa` is not the profiled DFA.
+    void train(const DFA& dfa, std::string_view sample);
+
+    bool fits(const DFA& dfa) const;
+    size_t size() const { return visits_.size(); }
+    uint64_t visits(StateId state) const { return visits_[state]; }
+    uint64_t transitions(StateId state, uint8_t byte) const;
+    const std::vector<uint64_t>& state_weights() const { return visits_; }
+    uint64_t total() const;
+
+    // Smallest set of states that together account for at least `coverage`
+    // (0..1] of all visits, hottest first. These are the states worth a
+    // dense row or other fast-path treatment. Ids are those of the
+    // profiled DFA.
+    std::vector<StateId> hot_states(double coverage) const;
+    // The same states numbered as in `dfa`, which is either the profiled
+    // DFA or the one compile() lays out with this profile. Throws
+    // std::invalid_argument for any other DFA.
+    std::vector<StateId> hot_states(const DFA& dfa, double coverage) const;
+
+    // Line-oriented text format; load() throws std::runtime_error on
+    // malformed input, including a state count above `max_states` (the
+    // limit the profiled DFA was compiled with), which is checked before
+    // anything is allocated for the states.
+    void save(std::ostream& out) const;
+    static Profile load(std::istream& in, size_t max_states = DEFAULT_STATE_LIMIT);
+
+private:
+    using Row = std::array<uint64_t, 256>;
+
+    Row& row(StateId state);
+
+    uint64_t fingerprint_ = 0;
+    std::vector<uint64_t> visits_;
+    std::vector<std::unique_ptr<Row>> counts_;
+};
+
+}
+
+#endif
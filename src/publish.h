@@ -0,0 +1,146 @@
+#ifndef FSA_PUBLISH_H
+#define FSA_PUBLISH_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace fsa {
+
+// Atomically replaceable pointer to an immutable compiled matcher (DFA,
+// HybridDFA, HFA, ...), with epoch-based reclamation of old versions.
+//
+// Readers never block or allocate: a read announces the current epoch in
+// the reader's slot and loads the pointer. publish() swaps in the new
+// version, advances the epoch and retires the old one, which is freed once
+// every reader has either gone idle or announced a later epoch. Writers
+// serialize on a mutex among themselves only.
+//
+// Each scanning thread registers a Reader once and reads through it:
+//
+//     Published<DFA>::Reader reader = published.reader();
+//     ...
+//     auto dfa = reader.lock();
+//     dfa->find(text);
+//
+// A Reader holds at most one Guard at a time and must not outlive the
+// Published it came from.
+template <class T>
+class Published {
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{IDLE};
+        std::atomic<bool> taken{false};
+    };
+
+public:
+    static constexpr uint64_t IDLE = UINT64_MAX;
+
+    class Guard {
+    public:
+        Guard(Guard&& other) noexcept : slot_(std::exchange(other.slot_, nullptr)), value_(other.value_){}
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        ~Guard(){ if(slot_) slot_->epoch.store(IDLE, std::memory_order_release); }
+
+        const T& operator*() const { return *value_; }
+        const T* operator->() const { return value_; }
+        const T* get() const { return value_; }
+
+    private:
+        friend class Published;
+        Guard(Slot* slot, const T* value) : slot_(slot), value_(value){}
+
+        Slot* slot_;
+        const T* value_;
+    };
+
+    class Reader {
+    public:
+        Reader(Reader&& other) noexcept
+            : owner_(std::exchange(other.owner_, nullptr)), slot_(std::exchange(other.slot_, nullptr)){}
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader(){ if(slot_) slot_->taken.store(false, std::memory_order_release); }
+
+        Guard lock() const {
+            slot_->epoch.store(owner_->epoch_.load());
+            return Guard(slot_, owner_->current_.load());
+        }
+
+    private:
+        friend class Published;
+        Reader(const Published* owner, Slot* slot) : owner_(owner), slot_(slot){}
+
+        const Published* owner_;
+        Slot* slot_;
+    };
+
+    explicit Published(std::unique_ptr<const T> initial, size_t max_readers = 64)
+        : slots_(max_readers), current_(initial.release()){}
+
+    Published(const Published&) = delete;
+    Published& operator=(const Published&) = delete;
+
+    // Requires every Reader to be gone.
+    ~Published(){
+        delete current_.load();
+        for(auto& r : retired_) delete r.second;
+    }
+
+    // Claims a reader slot. Throws std::runtime_error when all are taken.
+    Reader reader() const {
+        for(Slot& slot : slots_){
+            bool expected = false;
+            if(slot.taken.compare_exchange_strong(expected, true)) return Reader(this, &slot);
+        }
+        throw std::runtime_error("no free reader slots");
+    }
+
+    // Makes `next` visible to subsequent reads and reclaims what it can.
+    void publish(std::unique_ptr<const T> next){
+        std::lock_guard<std::mutex> lock(writer_);
+        const T* old = current_.exchange(next.release());
+        uint64_t retired_at = epoch_.fetch_add(1) + 1;
+        retired_.emplace_back(retired_at, old);
+        reclaim_locked();
+    }
+
+    // Frees retired versions no reader can still see; returns how many are
+    // still waiting for readers.
+    size_t reclaim(){
+        std::lock_guard<std::mutex> lock(writer_);
+        reclaim_locked();
+        return retired_.size();
+    }
+
+private:
+    void reclaim_locked(){
+        uint64_t oldest = IDLE;
+        for(const Slot& slot : slots_){
+            uint64_t e = slot.epoch.load();
+            if(e < oldest) oldest = e;
+        }
+        // A version retired at epoch r may be held by readers that announced
+        // an epoch below r.
+        size_t kept = 0;
+        for(auto& r : retired_){
+            if(r.first <= oldest) delete r.second;
+            else retired_[kept++] = r;
+        }
+        retired_.resize(kept);
+    }
+
+    mutable std::vector<Slot> slots_;
+    std::atomic<const T*> current_;
+    std::atomic<uint64_t> epoch_{0};
+    std::mutex writer_;
+    std::vector<std::pair<uint64_t, const T*>> retired_;
+};
+
+}
+
+#endif
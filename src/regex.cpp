@@ -0,0 +1,439 @@
+#include "regex.h"
+
+#include <algorithm>
+
+namespace fsa {
+
+Regex Regex::byte_set(const ByteSet& set){
+    Regex r;
+    r.kind = Kind::Bytes;
+    r.bytes = set;
+    return r;
+}
+
+Regex Regex::literal(std::string_view text){
+    std::vector<Regex> parts;
+    for(unsigned char c : text){
+        ByteSet set;
+        set.set(c);
+        parts.push_back(byte_set(set));
+    }
+    return concat(std::move(parts));
+}
+
+Regex Regex::concat(std::vector<Regex> parts){
+    if(parts.empty()) return empty();
+    if(parts.size() == 1) return std::move(parts[0]);
+    Regex r;
+    r.kind = Kind::Concat;
+    r.children = std::move(parts);
+    return r;
+}
+
+Regex Regex::alternate(std::vector<Regex> alternatives){
+    if(alternatives.size() == 1) return std::move(alternatives[0]);
+    Regex r;
+    r.kind = Kind::Alternate;
+    r.children = std::move(alternatives);
+    return r;
+}
+
+Regex Regex::repeat(Regex child, int min, int max){
+    Regex r;
+    r.kind = Kind::Repeat;
+    r.children.push_back(std::move(child));
+    r.min = min;
+    r.max = max;
+    return r;
+}
+
+bool is_wide_repeat(const Regex& regex){
+    return regex.kind == Regex::Kind::Repeat && regex.max == Regex::UNBOUNDED
+        && regex.children[0].kind == Regex::Kind::Bytes && regex.children[0].bytes.count() >= WIDE_SET;
+}
+
+int fixed_length(const Regex& regex){
+    switch(regex.kind){
+    case Regex::Kind::Empty:
+        return 0;
+    case Regex::Kind::Bytes:
+        return 1;
+    case Regex::Kind::Concat: {
+        int total = 0;
+        for(const Regex& child : regex.children){
+            int n = fixed_length(child);
+            if(n < 0) return -1;
+            total += n;
+        }
+        return total;
+    }
+    case Regex::Kind::Alternate: {
+        int n = fixed_length(regex.children[0]);
+        for(const Regex& child : regex.children){
+            if(fixed_length(child) != n) return -1;
+        }
+        return n;
+    }
+    case Regex::Kind::Repeat: {
+        int n = fixed_length(regex.children[0]);
+        if(n == 0) return 0;
+        if(n < 0 || regex.max != regex.min) return -1;
+        return n * regex.min;
+    }
+    }
+    return -1;
+}
+
+bool has_length_prefix(const Regex& regex){
+    if(regex.length_prefix) return true;
+    for(const Regex& child : regex.children){
+        if(has_length_prefix(child)) return true;
+    }
+    return false;
+}
+
+ByteSet bytes_used(const Regex& regex){
+    if(regex.kind == Regex::Kind::Bytes) return regex.bytes;
+    ByteSet set;
+    if(regex.kind == Regex::Kind::Repeat && regex.max == 0) return set;
+    for(const Regex& child : regex.children) set |= bytes_used(child);
+    return set;
+}
+
+Regex reversed(Regex regex){
+    if(regex.kind == Regex::Kind::Concat) std::reverse(regex.children.begin(), regex.children.end());
+    for(Regex& child : regex.children) child = reversed(std::move(child));
+    return regex;
+}
+
+namespace {
+
+ByteSet range(int lo, int hi){
+    ByteSet set;
+    for(int c = lo; c <= hi; c++) set.set(c);
+    return set;
+}
+
+ByteSet digit_set(){ return range('0', '9'); }
+
+ByteSet word_set(){
+    return range('0', '9') | range('a', 'z') | range('A', 'Z') | range('_', '_');
+}
+
+ByteSet space_set(){
+    ByteSet set = range('\t', '\r');
+    set.set(' ');
+    return set;
+}
+
+int hex_value(char c){
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+class Parser {
+public:
+    explicit Parser(std::string_view pattern) : p_(pattern){}
+
+    Regex run(){
+        Regex r = alternation();
+        if(pos_ < p_.size()) throw ParseError("unmatched ')'", pos_);
+        return r;
+    }
+
+private:
+    std::string_view p_;
+    size_t pos_ = 0;
+
+    bool done() const { return pos_ >= p_.size(); }
+    char peek() const { return p_[pos_]; }
+
+    Regex alternation(){
+        std::vector<Regex> alternatives;
+        alternatives.push_back(sequence());
+        while(!done() && peek() == '|'){
+            pos_++;
+            alternatives.push_back(sequence());
+        }
+        return Regex::alternate(std::move(alternatives));
+    }
+
+    Regex sequence(){
+        std::vector<Regex> parts;
+        while(!done() && peek() != '|' && peek() != ')'){
+            parts.push_back(quantified());
+        }
+        return Regex::concat(std::move(parts));
+    }
+
+    Regex quantified(){
+        Regex operand = atom();
+        while(!done()){
+            char c = peek();
+            if(c == '*'){
+                pos_++;
+                operand = Regex::repeat(std::move(operand), 0, Regex::UNBOUNDED);
+            }else if(c == '+'){
+                pos_++;
+                operand = Regex::repeat(std::move(operand), 1, Regex::UNBOUNDED);
+            }else if(c == '?'){
+                pos_++;
+                operand = Regex::repeat(std::move(operand), 0, 1);
+            }else if(c == '{' && counted_follows()){
+                size_t start = pos_;
+                pos_++;
+                int min = number();
+                int max = min;
+                if(peek() == ','){
+                    pos_++;
+                    max = peek() == '}' ? Regex::UNBOUNDED : number();
+                }
+                pos_++; // '}'
+                if(max != Regex::UNBOUNDED && max < min){
+                    throw ParseError("repetition bounds out of order", start);
+                }
+                if(min > MAX_REPEAT || max > MAX_REPEAT){
+                    throw ParseError("repetition count too large", start);
+                }
+                operand = Regex::repeat(std::move(operand), min, max);
+            }else{
+                break;
+            }
+        }
+        return operand;
+    }
+
+    // A '{' that does not start a well-formed {m}, {m,} or {m,n} is a literal.
+    bool counted_follows() const {
+        size_t i = pos_ + 1;
+        size_t digits = 0;
+        while(i < p_.size() && p_[i] >= '0' && p_[i] <= '9'){ i++; digits++; }
+        if(digits == 0 || i >= p_.size()) return false;
+        if(p_[i] == '}') return true;
+        if(p_[i] != ',') return false;
+        i++;
+        while(i < p_.size() && p_[i] >= '0' && p_[i] <= '9') i++;
+        return i < p_.size() && p_[i] == '}';
+    }
+
+    int number(){
+        long value = 0;
+        while(!done() && peek() >= '0' && peek() <= '9'){
+            value = value * 10 + (peek() - '0');
+            if(value > MAX_REPEAT) value = MAX_REPEAT + 1;
+            pos_++;
+        }
+        return static_cast<int>(value);
+    }
+
+    Regex atom(){
+        size_t start = pos_;
+        char c = peek();
+        switch(c){
+        case '(': {
+            pos_++;
+            int width = 0;
+            bool big_endian = false;
+            int max = 0;
+            if(p_.substr(pos_, 2) == "?:"){
+                pos_ += 2;
+            }else if(p_.substr(pos_, 3) == "?u8"){
+                pos_ += 3;
+                width = 1;
+                max = length_bound(start, 255);
+            }else if(p_.substr(pos_, 6) == "?u16be" || p_.substr(pos_, 6) == "?u16le"){
+                big_endian = p_[pos_ + 4] == 'b';
+                pos_ += 6;
+                width = 2;
+                max = length_bound(start, -1);
+            }
+            Regex inner = alternation();
+            if(done()) throw ParseError("unclosed '('", start);
+            pos_++;
+            return width ? length_prefixed(std::move(inner), width, big_endian, max) : inner;
+        }
+        case '[':
+            return Regex::byte_set(byte_class());
+        case '.':
+            pos_++;
+            return Regex::byte_set(~range('\n', '\n'));
+        case '\\':
+            if(p_.substr(pos_, 3) == "\\x{") return hex_string();
+            return Regex::byte_set(escape(false));
+        case '*':
+        case '+':
+        case '?':
+            throw ParseError("quantifier without operand", start);
+        default:
+            pos_++;
+            return Regex::byte_set(range(static_cast<unsigned char>(c), static_cast<unsigned char>(c)));
+        }
+    }
+
+    // Parses an escape starting at the backslash. Inside a class, \b is a
+    // backspace rather than an error.
+    ByteSet escape(bool in_class){
+        size_t start = pos_;
+        pos_++;
+        if(done()) throw ParseError("trailing backslash", start);
+        char c = p_[pos_++];
+        switch(c){
+        case 'd': return digit_set();
+        case 'D': return ~digit_set();
+        case 'w': return word_set();
+        case 'W': return ~word_set();
+        case 's': return space_set();
+        case 'S': return ~space_set();
+        case 'n': return range('\n', '\n');
+        case 'r': return range('\r', '\r');
+        case 't': return range('\t', '\t');
+        case 'f': return range('\f', '\f');
+        case 'v': return range('\v', '\v');
+        case '0': return range(0, 0);
+        case 'C': return ~ByteSet();
+        case 'x': {
+            int hi = pos_ < p_.size() ? hex_value(p_[pos_]) : -1;
+            int lo = pos_ + 1 < p_.size() ? hex_value(p_[pos_ + 1]) : -1;
+            if(hi < 0 || lo < 0) throw ParseError("\\x needs two hex digits", start);
+            pos_ += 2;
+            return range(hi * 16 + lo, hi * 16 + lo);
+        }
+        case 'b':
+            if(in_class) return range('\b', '\b');
+            throw ParseError("word boundaries are not supported", start);
+        default:
+            if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')){
+                throw ParseError(std::string("unknown escape \\") + c, start);
+            }
+            return range(static_cast<unsigned char>(c), static_cast<unsigned char>(c));
+        }
+    }
+
+    // \x{HHHH...}: the bytes spelled by pairs of hex digits.
+    Regex hex_string(){
+        size_t start = pos_;
+        pos_ += 3;
+        std::string bytes;
+        while(!done() && peek() != '}'){
+            int hi = hex_value(peek());
+            int lo = pos_ + 1 < p_.size() ? hex_value(p_[pos_ + 1]) : -1;
+            if(hi < 0 || lo < 0) throw ParseError("\\x{} needs pairs of hex digits", start);
+            bytes.push_back(static_cast<char>(hi * 16 + lo));
+            pos_ += 2;
+        }
+        if(done()) throw ParseError("unclosed \\x{", start);
+        if(bytes.empty()) throw ParseError("\\x{} needs pairs of hex digits", start);
+        pos_++; // '}'
+        return Regex::literal(bytes);
+    }
+
+    // The rest of a length group's header: an optional "<=N" and the ':'.
+    // Without a bound the largest length is `implied`; two-byte fields
+    // have none (implied < 0), since their full range would not fit.
+    int length_bound(size_t start, int implied){
+        int max = implied;
+        if(p_.substr(pos_, 2) == "<="){
+            pos_ += 2;
+            if(done() || peek() < '0' || peek() > '9') throw ParseError("length bound needs a number", start);
+            max = number();
+            if(max > MAX_REPEAT || (implied >= 0 && max > implied)){
+                throw ParseError("length bound too large", start);
+            }
+        }else if(implied < 0){
+            throw ParseError("two-byte length fields need a bound, as in (?u16be<=N:...)", start);
+        }
+        if(done() || peek() != ':') throw ParseError("length group needs ':'", start);
+        pos_++;
+        return max;
+    }
+
+    // A length field of `width` bytes holding n <= max, then n repetitions
+    // of the body. The counter becomes a chain A_k = A_(k+1) body | field(k)
+    // for k from max down to 0, so the copies of the body are shared by
+    // every length instead of spelled out once per length.
+    static Regex length_prefixed(Regex body, int width, bool big_endian, int max){
+        auto field = [&](int n){
+            if(width == 1) return Regex::byte_set(range(n, n));
+            std::vector<Regex> parts;
+            parts.push_back(Regex::byte_set(range(n >> 8, n >> 8)));
+            parts.push_back(Regex::byte_set(range(n & 0xff, n & 0xff)));
+            if(!big_endian) std::swap(parts[0], parts[1]);
+            return Regex::concat(std::move(parts));
+        };
+        Regex chain = field(max);
+        for(int k = max - 1; k >= 0; k--){
+            std::vector<Regex> longer;
+            longer.push_back(std::move(chain));
+            longer.push_back(body);
+            std::vector<Regex> alternatives;
+            alternatives.push_back(Regex::concat(std::move(longer)));
+            alternatives.push_back(field(k));
+            chain = Regex::alternate(std::move(alternatives));
+        }
+        chain.length_prefix = true;
+        return chain;
+    }
+
+    ByteSet byte_class(){
+        size_t start = pos_;
+        pos_++;
+        bool negated = false;
+        if(!done() && peek() == '^'){
+            negated = true;
+            pos_++;
+        }
+        ByteSet set;
+        bool first = true;
+        while(true){
+            if(done()) throw ParseError("unclosed '['", start);
+            if(peek() == ']' && !first) break;
+            first = false;
+            int lo;
+            if(peek() == '\\'){
+                ByteSet escaped = escape(true);
+                if(escaped.count() != 1){
+                    set |= escaped;
+                    continue;
+                }
+                lo = single(escaped);
+            }else{
+                lo = static_cast<unsigned char>(p_[pos_++]);
+            }
+            if(pos_ + 1 < p_.size() && peek() == '-' && p_[pos_ + 1] != ']'){
+                size_t dash = pos_;
+                pos_++;
+                int hi;
+                if(peek() == '\\'){
+                    ByteSet escaped = escape(true);
+                    if(escaped.count() != 1) throw ParseError("class range ends in a set", dash);
+                    hi = single(escaped);
+                }else{
+                    hi = static_cast<unsigned char>(p_[pos_++]);
+                }
+                if(hi < lo) throw ParseError("class range out of order", dash);
+                set |= range(lo, hi);
+            }else{
+                set.set(lo);
+            }
+        }
+        pos_++; // ']'
+        return negated ? ~set : set;
+    }
+
+    static int single(const ByteSet& set){
+        for(int c = 0; c < 256; c++){
+            if(set.test(c)) return c;
+        }
+        return 0;
+    }
+};
+
+}
+
+Regex parse(std::string_view pattern){
+    return Parser(pattern).run();
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef FSA_REGEX_H
+#define FSA_REGEX_H
+
+#include <bitset>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fsa {
+
+using ByteSet = std::bitset<256>;
+
+// Thrown by parse() with the byte offset of the offending character.
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& what, size_t pos)
+        : std::runtime_error(what + " at offset " + std::to_string(pos)), pos_(pos){}
+    size_t position() const { return pos_; }
+private:
+    size_t pos_;
+};
+
+// Regular expression syntax tree. Everything is over bytes; a Bytes node
+// matches exactly one byte from its set.
+struct Regex {
+    enum class Kind { Empty, Bytes, Concat, Alternate, Repeat };
+
+    static constexpr int UNBOUNDED = -1;
+
+    Kind kind = Kind::Empty;
+    ByteSet bytes;                 // Bytes
+    std::vector<Regex> children;   // Concat, Alternate, Repeat (one child)
+    int min = 0;                   // Repeat
+    int max = UNBOUNDED;           // Repeat
+    bool length_prefix = false;    // root of an expanded length group
+
+    static Regex empty(){ return Regex{}; }
+    static Regex byte_set(const ByteSet& set);
+    static Regex literal(std::string_view text);
+    static Regex concat(std::vector<Regex> parts);
+    static Regex alternate(std::vector<Regex> alternatives);
+    static Regex repeat(Regex child, int min, int max);
+};
+
+// Largest counted repetition accepted by parse(); {m,n} is expanded by
+// copying the operand, so this bounds the NFA size.
+constexpr int MAX_REPEAT = 1000;
+
+// Parses the supported syntax: literals, '.', classes ([a-z], [^...]),
+// escapes (\d \w \s \D \W \S \n \r \t \0 \xHH and escaped metacharacters),
+// groups ( (...) and (?:...) ), alternation, and the quantifiers * + ? {m}
+// {m,} {m,n}. There are no anchors: matching is either anchored at the
+// start of the input or unanchored, chosen at compile time.
+//
+// For binary formats there are also \C (any byte, newline included),
+// \x{HHHH...} (a byte string in hex), and length-prefixed groups:
+// (?u8:X) is a one-byte count n followed by n repetitions of X. With X = \C
+// the count is a length in bytes, so (?u8:\C)* matches a run of
+// length-value fields. (?u16be<=N:X) and (?u16le<=N:X) do the same with a
+// two-byte count, and (?u8<=N:X) narrows a one-byte one; counts above N
+// do not match. Every count up to N becomes DFA states, so N may not
+// exceed MAX_REPEAT and two-byte fields must state it. Length groups
+// only compile anchored: unanchored, a count could start at every byte.
+Regex parse(std::string_view pattern);
+
+// Repeats of byte sets at least this large count as `.*`-like.
+constexpr size_t WIDE_SET = 128;
+
+// True for an unbounded repeat of a single wide byte set, such as `.*`,
+// `[^\n]+` or `[\x00-\xff]*`.
+bool is_wide_repeat(const Regex& regex);
+
+// Length of every string the regex matches, or -1 if it varies.
+int fixed_length(const Regex& regex);
+
+// True if the regex contains a length-prefixed group.
+bool has_length_prefix(const Regex& regex);
+
+// Every byte that can appear in a match.
+ByteSet bytes_used(const Regex& regex);
+
+// The regex matching the reverse of every string this one matches, for
+// automata that read right to left.
+Regex reversed(Regex regex);
+
+}
+
+#endif
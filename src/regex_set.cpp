@@ -0,0 +1,226 @@
+#include "regex_set.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fsa {
+
+RegexSet::RegexSet(const RegexSetOptions& options) : options_(options){
+    scratch_.assign(nfa_.size(), false);
+    refresh_start();
+    flush();
+}
+
+RegexSet::RegexSet(const std::vector<std::string>& patterns, const RegexSetOptions& options) : RegexSet(options){
+    for(const std::string& pattern : patterns) add(pattern);
+}
+
+bool RegexSet::contains(PatternId id) const {
+    return id < patterns_.size() && patterns_[id].has_value();
+}
+
+PatternId RegexSet::add(std::string_view pattern){
+    Regex regex = parse(pattern);
+    PatternId id = static_cast<PatternId>(patterns_.size());
+    PatternId nfa_pattern = nfa_.add(regex);
+    patterns_.emplace_back(std::string(pattern));
+    public_id_.push_back(id);
+    nfa_id_[id] = nfa_pattern;
+    live_++;
+    scratch_.resize(nfa_.size(), false);
+
+    std::array<bool, 256> first = first_bytes(nfa_pattern);
+    for(int b = 0; b < 256; b++) first_count_[b] += first[b];
+    refresh_start();
+    invalidate_bytes(first);
+    return id;
+}
+
+void RegexSet::remove(PatternId id){
+    if(!contains(id)) throw std::invalid_argument("pattern " + std::to_string(id) + " is not in the set");
+    PatternId nfa_pattern = nfa_id_.at(id);
+    std::array<bool, 256> first = first_bytes(nfa_pattern);
+    for(int b = 0; b < 256; b++) first_count_[b] -= first[b];
+    nfa_.detach(nfa_pattern);
+    patterns_[id].reset();
+    nfa_id_.erase(id);
+    live_--;
+
+    auto range = nfa_.pattern_states(nfa_pattern);
+    detached_states_ += range.second - range.first;
+    if(detached_states_ * 2 > nfa_.size()){
+        rebuild();
+        return;
+    }
+    refresh_start();
+
+    // Drop cached states holding the pattern's NFA states, and every
+    // transition leading to them.
+    std::vector<bool> dropped(cache_.size(), false);
+    for(uint32_t s = 0; s < cache_.size(); s++){
+        Cached& c = cache_[s];
+        if(c.stale) continue;
+        auto it = std::lower_bound(c.residual.begin(), c.residual.end(), range.first);
+        if(it == c.residual.end() || *it >= range.second) continue;
+        ids_.erase(c.residual);
+        c.stale = true;
+        c.residual.clear();
+        c.matches.clear();
+        dropped[s] = true;
+        stale_++;
+    }
+    for(uint32_t& t : transitions_){
+        if(t != UNKNOWN && dropped[t]) t = UNKNOWN;
+    }
+    if(stale_ * 2 > cache_.size()) flush();
+}
+
+std::array<bool, 256> RegexSet::first_bytes(PatternId nfa_pattern) const {
+    std::array<bool, 256> first{};
+    auto range = nfa_.pattern_states(nfa_pattern);
+    // A fragment's entry is always the first state built for it.
+    std::vector<StateId> entry{range.first};
+    nfa_.closure(entry);
+    for(StateId s : entry){
+        for(const NFA::Transition& t : nfa_.state(s).transitions){
+            for(int b = t.lo; b <= t.hi; b++) first[b] = true;
+        }
+    }
+    return first;
+}
+
+void RegexSet::refresh_start(){
+    start_closure_.assign(1, nfa_.start());
+    nfa_.closure(start_closure_, scratch_);
+    in_start_closure_.assign(nfa_.size(), false);
+    start_matches_.clear();
+    for(StateId s : start_closure_){
+        in_start_closure_[s] = true;
+        PatternId p = nfa_.state(s).match;
+        if(p != NFA::NO_MATCH) start_matches_.push_back(public_id_[p]);
+    }
+    std::sort(start_matches_.begin(), start_matches_.end());
+}
+
+void RegexSet::invalidate_bytes(const std::array<bool, 256>& bytes){
+    for(size_t s = 0; s < cache_.size(); s++){
+        uint32_t* row = &transitions_[s * 256];
+        for(int b = 0; b < 256; b++){
+            if(bytes[b]) row[b] = UNKNOWN;
+        }
+    }
+}
+
+void RegexSet::flush(){
+    cache_.clear();
+    transitions_.clear();
+    ids_.clear();
+    stale_ = 0;
+    intern({});
+}
+
+void RegexSet::rebuild(){
+    NFA fresh;
+    public_id_.clear();
+    nfa_id_.clear();
+    for(PatternId id = 0; id < patterns_.size(); id++){
+        if(!patterns_[id]) continue;
+        nfa_id_[id] = fresh.add(*patterns_[id]);
+        public_id_.push_back(id);
+    }
+    nfa_ = std::move(fresh);
+    detached_states_ = 0;
+    scratch_.assign(nfa_.size(), false);
+    first_count_.fill(0);
+    for(PatternId p = 0; p < nfa_.pattern_count(); p++){
+        std::array<bool, 256> first = first_bytes(p);
+        for(int b = 0; b < 256; b++) first_count_[b] += first[b];
+    }
+    refresh_start();
+    flush();
+}
+
+uint32_t RegexSet::intern(std::vector<StateId>&& residual){
+    auto it = ids_.find(residual);
+    if(it != ids_.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(cache_.size());
+    Cached c;
+    for(StateId s : residual){
+        PatternId p = nfa_.state(s).match;
+        if(p != NFA::NO_MATCH) c.matches.push_back(public_id_[p]);
+    }
+    std::sort(c.matches.begin(), c.matches.end());
+    c.residual = std::move(residual);
+    ids_.emplace(c.residual, id);
+    cache_.push_back(std::move(c));
+    transitions_.resize(transitions_.size() + 256, UNKNOWN);
+    return id;
+}
+
+uint32_t RegexSet::step(uint32_t state, uint8_t byte){
+    std::vector<StateId> moved;
+    auto follow = [&](StateId s){
+        for(const NFA::Transition& t : nfa_.state(s).transitions){
+            if(t.lo <= byte && byte <= t.hi) moved.push_back(t.to);
+        }
+    };
+    for(StateId s : cache_[state].residual) follow(s);
+    for(StateId s : start_closure_) follow(s);
+    nfa_.closure(moved, scratch_);
+    moved.erase(std::remove_if(moved.begin(), moved.end(), [this](StateId s){
+        return in_start_closure_[s];
+    }), moved.end());
+    if(cache_.size() >= options_.max_cached_states){
+        flush();
+        return intern(std::move(moved));
+    }
+    uint32_t to = intern(std::move(moved));
+    transitions_[static_cast<size_t>(state) * 256 + byte] = to;
+    return to;
+}
+
+template <class OnMatch>
+void RegexSet::scan(std::string_view text, OnMatch on_match){
+    if(!start_matches_.empty() && !on_match(start_matches_)) return;
+    uint32_t s = 0;
+    size_t i = 0;
+    size_t n = text.size();
+    while(i < n){
+        if(s == 0){
+            // Prefilter: nothing can start on bytes no pattern begins with.
+            while(i < n && first_count_[static_cast<unsigned char>(text[i])] == 0) i++;
+            if(i == n) break;
+        }
+        uint8_t c = static_cast<uint8_t>(text[i++]);
+        uint32_t t = transitions_[static_cast<size_t>(s) * 256 + c];
+        s = t != UNKNOWN ? t : step(s, c);
+        if(!cache_[s].matches.empty() && !on_match(cache_[s].matches)) return;
+    }
+}
+
+std::vector<PatternId> RegexSet::match_set(std::string_view text){
+    std::vector<bool> seen(patterns_.size(), false);
+    std::vector<PatternId> found;
+    scan(text, [&](const std::vector<PatternId>& matches){
+        for(PatternId p : matches){
+            if(!seen[p]){
+                seen[p] = true;
+                found.push_back(p);
+            }
+        }
+        return found.size() < live_;
+    });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+bool RegexSet::find(std::string_view text){
+    bool matched = false;
+    scan(text, [&matched](const std::vector<PatternId>&){
+        matched = true;
+        return false;
+    });
+    return matched;
+}
+
+}
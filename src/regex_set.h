@@ -0,0 +1,102 @@
+#ifndef FSA_REGEX_SET_H
+#define FSA_REGEX_SET_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "nfa.h"
+
+namespace fsa {
+
+struct RegexSetOptions {
+    // The lazy DFA cache is flushed when it grows past this many states.
+    size_t max_cached_states = 10000;
+};
+
+// Unanchored multi-pattern matcher that accepts pattern additions and
+// removals without recompiling. Patterns live in one NFA; a lazy DFA cache
+// determinizes states as the input reaches them.
+//
+// Cached states are keyed by their NFA states minus the start closure,
+// which every unanchored state implicitly contains. Adding a pattern then
+// only changes transitions on its first bytes, and removing one only
+// affects the cached states that contain its NFA states. Those are the
+// only cache entries an update drops.
+//
+// A first-byte prefilter skips input while the scan is in the start state.
+// It is a per-byte count of patterns that can begin with that byte, so
+// updates adjust it in place.
+//
+// Matching fills the cache, so a RegexSet must not be scanned from several
+// threads at once.
+class RegexSet {
+public:
+    RegexSet() : RegexSet(RegexSetOptions{}){}
+    explicit RegexSet(const RegexSetOptions& options);
+    explicit RegexSet(const std::vector<std::string>& patterns, const RegexSetOptions& options = {});
+
+    // Returns the new pattern's id. Ids are never reused. Throws ParseError.
+    PatternId add(std::string_view pattern);
+    // Throws std::invalid_argument if `id` is not in the set.
+    void remove(PatternId id);
+
+    bool contains(PatternId id) const;
+    size_t size() const { return live_; }
+    size_t cached_states() const { return cache_.size() - stale_; }
+
+    // Every pattern that matches somewhere in `text`, sorted.
+    std::vector<PatternId> match_set(std::string_view text);
+    bool find(std::string_view text);
+
+private:
+    static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+    struct Cached {
+        std::vector<StateId> residual;
+        std::vector<PatternId> matches;   // public ids
+        bool stale = false;
+    };
+
+    uint32_t intern(std::vector<StateId>&& residual);
+    uint32_t step(uint32_t state, uint8_t byte);
+    void flush();
+    void rebuild();
+    void invalidate_bytes(const std::array<bool, 256>& bytes);
+    std::array<bool, 256> first_bytes(PatternId nfa_pattern) const;
+    void refresh_start();
+
+    template <class OnMatch>
+    void scan(std::string_view text, OnMatch on_match);
+
+    RegexSetOptions options_;
+    NFA nfa_;
+    // Indexed by public id; nullopt once removed.
+    std::vector<std::optional<std::string>> patterns_;
+    // NFA pattern id -> public id.
+    std::vector<PatternId> public_id_;
+    // Public id -> NFA pattern id, for live patterns.
+    std::unordered_map<PatternId, PatternId> nfa_id_;
+    size_t live_ = 0;
+    size_t detached_states_ = 0;
+
+    std::vector<StateId> start_closure_;
+    std::vector<bool> in_start_closure_;
+    std::vector<PatternId> start_matches_;
+    std::vector<bool> scratch_;
+
+    std::vector<Cached> cache_;
+    std::vector<uint32_t> transitions_;
+    std::unordered_map<std::vector<StateId>, uint32_t, StateSetHash> ids_;
+    size_t stale_ = 0;
+
+    std::array<uint32_t, 256> first_count_{};
+};
+
+}
+
+#endif
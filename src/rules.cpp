@@ -0,0 +1,21 @@
+#include "rules.h"
+
+#include <istream>
+
+namespace fsa {
+
+std::vector<std::string> read_rules(std::istream& in, std::vector<size_t>* lines){
+    std::vector<std::string> rules;
+    std::string line;
+    size_t number = 0;
+    while(std::getline(in, line)){
+        number++;
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.empty() || line[0] == '#') continue;
+        rules.push_back(line);
+        if(lines) lines->push_back(number);
+    }
+    return rules;
+}
+
+}
@@ -0,0 +1,17 @@
+#ifndef FSA_RULES_H
+#define FSA_RULES_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace fsa {
+
+// Reads a rule file: one pattern per line. Blank lines and lines starting
+// with '#' are skipped, and a trailing '\r' is removed. `lines`, if given,
+// receives the 1-based line number of each pattern for error messages.
+std::vector<std::string> read_rules(std::istream& in, std::vector<size_t>* lines = nullptr);
+
+}
+
+#endif
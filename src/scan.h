@@ -0,0 +1,69 @@
+#ifndef FSA_SCAN_H
+#define FSA_SCAN_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "nfa.h"
+
+namespace fsa {
+
+// Scan loops shared by every DFA representation. An Automaton provides
+// start(), next(state, byte), accepting(state), matches(state) (iterable
+// PatternIds), pattern_count(), and the DEAD sentinel.
+
+template <class Automaton>
+bool scan_find(const Automaton& a, std::string_view text){
+    StateId s = a.start();
+    if(s == Automaton::DEAD) return false;
+    if(a.accepting(s)) return true;
+    for(unsigned char c : text){
+        s = a.next(s, c);
+        if(s == Automaton::DEAD) return false;
+        if(a.accepting(s)) return true;
+    }
+    return false;
+}
+
+template <class Automaton>
+bool scan_accepts(const Automaton& a, std::string_view text){
+    StateId s = a.start();
+    for(unsigned char c : text){
+        if(s == Automaton::DEAD) return false;
+        s = a.next(s, c);
+    }
+    return s != Automaton::DEAD && a.accepting(s);
+}
+
+template <class Automaton>
+std::vector<PatternId> scan_match_set(const Automaton& a, std::string_view text){
+    std::vector<bool> seen(a.pattern_count(), false);
+    std::vector<PatternId> found;
+    auto collect = [&](StateId s){
+        for(PatternId p : a.matches(s)){
+            if(!seen[p]){
+                seen[p] = true;
+                found.push_back(p);
+            }
+        }
+    };
+    StateId s = a.start();
+    if(s == Automaton::DEAD) return found;
+    collect(s);
+    for(unsigned char c : text){
+        s = a.next(s, c);
+        if(s == Automaton::DEAD) break;
+        if(a.accepting(s)){
+            collect(s);
+            if(found.size() == a.pattern_count()) break;
+        }
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+}
+
+#endif
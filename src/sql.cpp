@@ -0,0 +1,193 @@
+#include "sql.h"
+
+#include <string>
+
+#include "compile.h"
+
+namespace fsa {
+
+namespace {
+
+ByteSet range(int lo, int hi){
+    ByteSet set;
+    for(int c = lo; c <= hi; c++) set.set(c);
+    return set;
+}
+
+// One character: a byte, or a UTF-8 sequence when `utf8` is set.
+Regex any_character(bool utf8){
+    if(!utf8) return Regex::byte_set(range(0, 255));
+    Regex tail = Regex::byte_set(range(0x80, 0xbf));
+    return Regex::alternate({
+        Regex::byte_set(range(0, 0x7f)),
+        Regex::concat({Regex::byte_set(range(0xc0, 0xdf)), tail}),
+        Regex::concat({Regex::byte_set(range(0xe0, 0xef)), Regex::repeat(tail, 2, 2)}),
+        Regex::concat({Regex::byte_set(range(0xf0, 0xf7)), Regex::repeat(tail, 3, 3)}),
+    });
+}
+
+// The same syntax as any_character(), for rewritten SIMILAR TO patterns.
+const char* ANY_UTF8 = "(?:[\\x00-\\x7f]|[\\xc0-\\xdf][\\x80-\\xbf]|[\\xe0-\\xef][\\x80-\\xbf]{2}|[\\xf0-\\xf7][\\x80-\\xbf]{3})";
+
+void fold_case(Regex& regex){
+    if(regex.kind == Regex::Kind::Bytes){
+        for(int c = 'a'; c <= 'z'; c++){
+            if(regex.bytes.test(c) || regex.bytes.test(c - 'a' + 'A')){
+                regex.bytes.set(c);
+                regex.bytes.set(c - 'a' + 'A');
+            }
+        }
+    }
+    for(Regex& child : regex.children) fold_case(child);
+}
+
+std::string hex_escape(unsigned char c){
+    const char* digits = "0123456789abcdef";
+    return std::string("\\x") + digits[c >> 4] + digits[c & 15];
+}
+
+// Rewrites SIMILAR TO into regex syntax; origin[i] is the pattern offset
+// that output byte i came from.
+class SimilarRewriter {
+public:
+    SimilarRewriter(std::string_view pattern, const SqlPatternOptions& options) : p_(pattern), options_(options){}
+
+    std::string run(){
+        while(pos_ < p_.size()){
+            size_t start = pos_;
+            char c = p_[pos_++];
+            if(options_.escape && c == options_.escape){
+                if(pos_ == p_.size()) throw ParseError("escape character at end of pattern", start);
+                emit(hex_escape(static_cast<unsigned char>(p_[pos_++])), start);
+            }else if(c == '%'){
+                emit("[\\x00-\\xff]*", start);
+            }else if(c == '_'){
+                emit(options_.utf8 ? ANY_UTF8 : "[\\x00-\\xff]", start);
+            }else if(c == '['){
+                byte_class(start);
+            }else if(c == '|' || c == '*' || c == '+' || c == '?' || c == '(' || c == ')' || c == '{' || c == '}' || c == ','
+                      || (c >= '0' && c <= '9')){
+                emit(std::string(1, c), start);
+            }else{
+                emit(hex_escape(static_cast<unsigned char>(c)), start);
+            }
+        }
+        return out_;
+    }
+
+    size_t origin(size_t offset) const {
+        return offset < origin_.size() ? origin_[offset] : p_.size();
+    }
+
+private:
+    void emit(const std::string& text, size_t from){
+        out_ += text;
+        origin_.insert(origin_.end(), text.size(), from);
+    }
+
+    // Copies a class, escaping its members so only '^', '-' and ']' keep
+    // their meaning.
+    void byte_class(size_t start){
+        emit("[", start);
+        if(pos_ < p_.size() && p_[pos_] == '^') emit("^", pos_++);
+        bool first = true;
+        while(true){
+            if(pos_ == p_.size()) throw ParseError("unclosed '['", start);
+            size_t at = pos_;
+            char c = p_[pos_++];
+            if(c == ']' && !first){
+                emit("]", at);
+                return;
+            }
+            if(c == '-' && !first && pos_ < p_.size() && p_[pos_] != ']'){
+                emit("-", at);
+                continue;
+            }
+            first = false;
+            if(options_.escape && c == options_.escape && pos_ < p_.size()) c = p_[pos_++];
+            emit(hex_escape(static_cast<unsigned char>(c)), at);
+        }
+    }
+
+    std::string_view p_;
+    SqlPatternOptions options_;
+    size_t pos_ = 0;
+    std::string out_;
+    std::vector<size_t> origin_;
+};
+
+}
+
+Regex parse_like(std::string_view pattern, const SqlPatternOptions& options){
+    std::vector<Regex> parts;
+    for(size_t i = 0; i < pattern.size(); i++){
+        char c = pattern[i];
+        if(options.escape && c == options.escape){
+            if(i + 1 == pattern.size()) throw ParseError("escape character at end of pattern", i);
+            parts.push_back(Regex::literal(pattern.substr(++i, 1)));
+        }else if(c == '%'){
+            parts.push_back(Regex::repeat(any_character(false), 0, Regex::UNBOUNDED));
+        }else if(c == '_'){
+            parts.push_back(any_character(options.utf8));
+        }else{
+            parts.push_back(Regex::literal(pattern.substr(i, 1)));
+        }
+    }
+    Regex regex = Regex::concat(std::move(parts));
+    if(options.case_insensitive) fold_case(regex);
+    return regex;
+}
+
+Regex parse_similar(std::string_view pattern, const SqlPatternOptions& options){
+    SimilarRewriter rewriter(pattern, options);
+    std::string rewritten = rewriter.run();
+    Regex regex;
+    try{
+        regex = parse(rewritten);
+    }catch(const ParseError& e){
+        std::string what = e.what();
+        what = what.substr(0, what.rfind(" at offset "));
+        throw ParseError(what, rewriter.origin(e.position()));
+    }
+    if(options.case_insensitive) fold_case(regex);
+    return regex;
+}
+
+SqlMatcher::SqlMatcher(SqlSyntax syntax, std::string_view pattern, const SqlPatternOptions& options){
+    NFA nfa;
+    nfa.add(syntax == SqlSyntax::Like ? parse_like(pattern, options) : parse_similar(pattern, options));
+    CompileOptions compile_options;
+    compile_options.anchored = true;
+    dfa_ = compile(nfa, compile_options);
+    absorbing_ = absorbing_states(dfa_);
+}
+
+bool SqlMatcher::matches(std::string_view value) const {
+    uint8_t result;
+    evaluate(&value, 1, &result);
+    return result;
+}
+
+void SqlMatcher::evaluate(const std::string_view* values, size_t count, uint8_t* results) const {
+    accepts_batch(dfa_, values, count, results, &absorbing_);
+}
+
+std::vector<uint8_t> SqlMatcher::evaluate(const std::vector<std::string_view>& values) const {
+    std::vector<uint8_t> results(values.size());
+    evaluate(values.data(), values.size(), results.data());
+    return results;
+}
+
+void SqlMatcher::filter(const StringColumn<int32_t>& column, uint8_t* selection) const {
+    ColumnFilter options;
+    options.absorbing = &absorbing_;
+    filter_column(dfa_, column, selection, options);
+}
+
+void SqlMatcher::filter(const StringColumn<int64_t>& column, uint8_t* selection) const {
+    ColumnFilter options;
+    options.absorbing = &absorbing_;
+    filter_column(dfa_, column, selection, options);
+}
+
+}
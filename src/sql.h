@@ -0,0 +1,67 @@
+#ifndef FSA_SQL_H
+#define FSA_SQL_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "batch.h"
+#include "dfa.h"
+#include "regex.h"
+
+namespace fsa {
+
+enum class SqlSyntax { Like, SimilarTo };
+
+struct SqlPatternOptions {
+    // Makes the next character literal; 0 for none. PostgreSQL's default.
+    char escape = '\\';
+    // ILIKE: ASCII letters match either case.
+    bool case_insensitive = false;
+    // '_' matches one UTF-8 encoded character rather than one byte. '%'
+    // matches any run of bytes either way, in LIKE and SIMILAR TO alike:
+    // on valid UTF-8 that is any run of characters, and values that are
+    // not valid UTF-8 still match where the rest of the pattern does.
+    bool utf8 = true;
+};
+
+// LIKE: '%' matches any run of characters, '_' exactly one, and the escape
+// character makes the next character literal. Throws ParseError for an
+// escape character at the end.
+Regex parse_like(std::string_view pattern, const SqlPatternOptions& options = {});
+
+// SIMILAR TO: LIKE's '%' and '_' plus | * + ? {m} {m,} {m,n} ( ) and
+// [...] classes; every other character, '.' included, is literal. The
+// pattern is rewritten into regex syntax and parsed, the way PostgreSQL
+// does it; ParseError offsets refer to the SQL pattern.
+Regex parse_similar(std::string_view pattern, const SqlPatternOptions& options = {});
+
+// A compiled LIKE or SIMILAR TO predicate. Both match the whole value, so
+// the pattern compiles to an anchored DFA and `%a%b%c%` costs one pass
+// over the value rather than backtracking.
+class SqlMatcher {
+public:
+    SqlMatcher(SqlSyntax syntax, std::string_view pattern, const SqlPatternOptions& options = {});
+
+    bool matches(std::string_view value) const;
+
+    // matches() for each value of a column batch, through accepts_batch():
+    // results[i] is 1 if values[i] matches.
+    void evaluate(const std::string_view* values, size_t count, uint8_t* results) const;
+    std::vector<uint8_t> evaluate(const std::vector<std::string_view>& values) const;
+
+    // Selection bitmap for an Arrow string or large_string column, through
+    // filter_column().
+    void filter(const StringColumn<int32_t>& column, uint8_t* selection) const;
+    void filter(const StringColumn<int64_t>& column, uint8_t* selection) const;
+
+    const DFA& dfa() const { return dfa_; }
+
+private:
+    DFA dfa_;
+    std::vector<bool> absorbing_;
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FSA_STREAM_H
+#define FSA_STREAM_H
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "nfa.h"
+
+namespace fsa {
+
+// match_set() over input that arrives in pieces: the automaton state is
+// carried from one chunk to the next, so chunk boundaries never hide a
+// match. Works with any automaton the scan.h loops accept.
+template <class Automaton>
+class StreamMatcher {
+public:
+    explicit StreamMatcher(const Automaton& automaton) : automaton_(&automaton){ reset(); }
+
+    void reset(){
+        state_ = automaton_->start();
+        seen_.assign(automaton_->pattern_count(), false);
+        found_.clear();
+        if(state_ != Automaton::DEAD) collect();
+    }
+
+    void feed(std::string_view chunk){
+        const Automaton& a = *automaton_;
+        for(unsigned char c : chunk){
+            if(done()) return;
+            state_ = a.next(state_, c);
+            if(state_ == Automaton::DEAD) return;
+            if(a.accepting(state_)) collect();
+        }
+    }
+
+    // True once more input cannot change matches(): every pattern has
+    // matched, or an anchored automaton has died.
+    bool done() const {
+        return state_ == Automaton::DEAD || found_.size() == automaton_->pattern_count();
+    }
+
+    // Patterns matched so far, sorted.
+    std::vector<PatternId> matches() const {
+        std::vector<PatternId> sorted = found_;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+private:
+    void collect(){
+        for(PatternId p : automaton_->matches(state_)){
+            if(!seen_[p]){
+                seen_[p] = true;
+                found_.push_back(p);
+            }
+        }
+    }
+
+    const Automaton* automaton_;
+    StateId state_;
+    std::vector<bool> seen_;
+    std::vector<PatternId> found_;
+};
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "suffix_automaton.h"
+
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+namespace fsa {
+
+namespace {
+
+constexpr uint32_t NONE = UINT32_MAX;
+
+// Automaton under construction. Each state's edges are a singly linked
+// list in shared flat arrays rather than a container per state, so the
+// build costs a fixed number of bytes per state and edge.
+struct Builder {
+    std::vector<uint32_t> length;
+    std::vector<uint32_t> link;
+    std::vector<uint32_t> head;       // first edge, NONE if none
+    std::vector<bool> clone;
+    std::vector<uint8_t> label;
+    std::vector<uint32_t> target;
+    std::vector<uint32_t> next_edge;
+
+    uint32_t add_state(uint32_t len, bool cloned){
+        length.push_back(len);
+        link.push_back(NONE);
+        head.push_back(NONE);
+        clone.push_back(cloned);
+        return static_cast<uint32_t>(length.size() - 1);
+    }
+
+    uint32_t find(uint32_t state, uint8_t c) const {
+        for(uint32_t e = head[state]; e != NONE; e = next_edge[e]){
+            if(label[e] == c) return e;
+        }
+        return NONE;
+    }
+
+    void add_edge(uint32_t state, uint8_t c, uint32_t to){
+        label.push_back(c);
+        target.push_back(to);
+        next_edge.push_back(head[state]);
+        head[state] = static_cast<uint32_t>(label.size() - 1);
+    }
+};
+
+uint64_t pair_key(StateId a, StateId b){
+    return static_cast<uint64_t>(a) << 32 | b;
+}
+
+}
+
+SuffixAutomaton::SuffixAutomaton(std::string_view text){
+    if(text.size() >= (size_t{1} << 31)) throw std::length_error("suffix automaton corpus too large");
+    Builder b;
+    b.length.reserve(2 * text.size() + 1);
+    b.link.reserve(2 * text.size() + 1);
+    b.head.reserve(2 * text.size() + 1);
+    b.add_state(0, false);
+    uint32_t last = 0;
+    for(unsigned char c : text){
+        uint32_t cur = b.add_state(b.length[last] + 1, false);
+        uint32_t p = last;
+        uint32_t e;
+        while(p != NONE && (e = b.find(p, c)) == NONE){
+            b.add_edge(p, c, cur);
+            p = b.link[p];
+        }
+        if(p == NONE){
+            b.link[cur] = 0;
+        }else{
+            uint32_t q = b.target[e];
+            if(b.length[p] + 1 == b.length[q]){
+                b.link[cur] = q;
+            }else{
+                uint32_t copy = b.add_state(b.length[p] + 1, true);
+                for(uint32_t f = b.head[q]; f != NONE; f = b.next_edge[f]) b.add_edge(copy, b.label[f], b.target[f]);
+                b.link[copy] = b.link[q];
+                for(; p != NONE && (e = b.find(p, c)) != NONE && b.target[e] == q; p = b.link[p]){
+                    b.target[e] = copy;
+                }
+                b.link[q] = copy;
+                b.link[cur] = copy;
+            }
+        }
+        last = cur;
+    }
+
+    // Occurrences: one per end position, summed up the suffix links from
+    // the longest states down (counting sort by length).
+    size_t n = b.length.size();
+    counts_.assign(n, 0);
+    {
+        std::vector<uint32_t> by_length(text.size() + 2, 0);
+        for(uint32_t len : b.length) by_length[len + 1]++;
+        for(size_t i = 1; i < by_length.size(); i++) by_length[i] += by_length[i - 1];
+        std::vector<uint32_t> order(n);
+        for(uint32_t s = 0; s < n; s++) order[by_length[b.length[s]]++] = s;
+        for(uint32_t s = 1; s < n; s++) counts_[s] = b.clone[s] ? 0 : 1;
+        for(size_t i = n; i-- > 1;){
+            uint32_t s = order[i];
+            counts_[b.link[s]] += counts_[s];
+        }
+        counts_[0] = static_cast<uint32_t>(text.size() + 1);
+    }
+    std::vector<uint32_t>().swap(b.length);
+    std::vector<uint32_t>().swap(b.link);
+
+    // Sorted per-state edge arrays, the layout next() searches.
+    begin_.reserve(n + 1);
+    begin_.push_back(0);
+    labels_.reserve(b.label.size());
+    targets_.reserve(b.label.size());
+    std::vector<std::pair<uint8_t, uint32_t>> edges;
+    for(uint32_t s = 0; s < n; s++){
+        edges.clear();
+        for(uint32_t e = b.head[s]; e != NONE; e = b.next_edge[e]) edges.emplace_back(b.label[e], b.target[e]);
+        std::sort(edges.begin(), edges.end());
+        for(const auto& edge : edges){
+            labels_.push_back(edge.first);
+            targets_.push_back(edge.second);
+        }
+        begin_.push_back(static_cast<uint32_t>(labels_.size()));
+    }
+}
+
+bool SuffixAutomaton::contains(std::string_view pattern) const {
+    StateId s = start();
+    for(unsigned char c : pattern){
+        s = next(s, c);
+        if(s == DEAD) return false;
+    }
+    return true;
+}
+
+size_t SuffixAutomaton::count(std::string_view pattern) const {
+    StateId s = start();
+    for(unsigned char c : pattern){
+        s = next(s, c);
+        if(s == DEAD) return 0;
+    }
+    return counts_[s];
+}
+
+bool SuffixAutomaton::intersects(const DFA& dfa) const {
+    if(dfa.start() == DFA::DEAD) return false;
+    std::unordered_set<uint64_t> seen;
+    std::vector<std::pair<StateId, StateId>> stack{{start(), dfa.start()}};
+    seen.insert(pair_key(start(), dfa.start()));
+    while(!stack.empty()){
+        auto [s, d] = stack.back();
+        stack.pop_back();
+        for(uint32_t i = begin_[s]; i < begin_[s + 1]; i++){
+            StateId t = dfa.next(d, labels_[i]);
+            if(t == DFA::DEAD) continue;
+            if(dfa.accepting(t)) return true;
+            if(seen.insert(pair_key(targets_[i], t)).second) stack.push_back({targets_[i], t});
+        }
+    }
+    return false;
+}
+
+std::vector<SubstringMatch> SuffixAutomaton::matches(const DFA& dfa, size_t limit) const {
+    std::vector<SubstringMatch> found;
+    if(dfa.start() == DFA::DEAD || limit == 0) return found;
+    // Depth-first over the product, one frame per byte of the current
+    // substring. Pairs whose whole subtree held no match are remembered so
+    // their other paths are not walked again.
+    struct Frame {
+        StateId s;
+        StateId d;
+        uint32_t edge;
+        bool fruitful;
+    };
+    std::unordered_set<uint64_t> fruitless;
+    std::vector<Frame> stack{{start(), dfa.start(), begin_[start()], false}};
+    std::string text;
+    while(!stack.empty()){
+        Frame& top = stack.back();
+        if(top.edge == begin_[top.s + 1] || found.size() == limit){
+            if(!top.fruitful) fruitless.insert(pair_key(top.s, top.d));
+            bool fruitful = top.fruitful;
+            stack.pop_back();
+            if(!stack.empty()){
+                stack.back().fruitful |= fruitful;
+                text.pop_back();
+            }
+            continue;
+        }
+        uint32_t i = top.edge++;
+        StateId t = dfa.next(top.d, labels_[i]);
+        StateId s = targets_[i];
+        if(t == DFA::DEAD || fruitless.count(pair_key(s, t))) continue;
+        text.push_back(static_cast<char>(labels_[i]));
+        bool accepting = dfa.accepting(t);
+        if(accepting) found.push_back({text, counts_[s]});
+        stack.push_back({s, t, begin_[s], accepting});
+    }
+    return found;
+}
+
+size_t SuffixAutomaton::memory_usage() const {
+    return begin_.size() * sizeof(uint32_t) + labels_.size() + targets_.size() * sizeof(StateId)
+         + counts_.size() * sizeof(uint32_t);
+}
+
+}
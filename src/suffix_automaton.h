@@ -0,0 +1,67 @@
+#ifndef FSA_SUFFIX_AUTOMATON_H
+#define FSA_SUFFIX_AUTOMATON_H
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+struct SubstringMatch {
+    std::string text;
+    size_t count;   // occurrences in the corpus
+};
+
+// Suffix automaton (DAWG) of a corpus: the minimal DFA accepting every
+// substring, built online in linear time with at most 2n states and 3n
+// edges. Each state keeps its edges sorted by byte in one flat array, so
+// a step is a binary search over a few bytes, plus the number of times
+// the substrings reaching it occur. Queries cost time in the pattern, not
+// the corpus. The corpus must be shorter than 2^31 bytes. The finished
+// index takes about 25 bytes per corpus byte and the build peaks near 60,
+// so indexing 2 GB of text needs on the order of 120 GB of memory.
+class SuffixAutomaton {
+public:
+    static constexpr StateId DEAD = DFA::DEAD;
+
+    explicit SuffixAutomaton(std::string_view text);
+
+    StateId start() const { return 0; }
+    StateId next(StateId state, uint8_t byte) const {
+        const uint8_t* first = labels_.data() + begin_[state];
+        const uint8_t* last = labels_.data() + begin_[state + 1];
+        const uint8_t* it = std::lower_bound(first, last, byte);
+        return it != last && *it == byte ? targets_[static_cast<size_t>(it - labels_.data())] : DEAD;
+    }
+
+    bool contains(std::string_view pattern) const;
+    // Occurrences of the pattern, overlapping ones included; the empty
+    // pattern occurs text.size() + 1 times.
+    size_t count(std::string_view pattern) const;
+
+    // True if some non-empty substring of the corpus is accepted by the
+    // DFA, which should be anchored: it judges whole substrings. Walks the
+    // product of both automata, visiting each pair of states once.
+    bool intersects(const DFA& dfa) const;
+    // Up to `limit` distinct non-empty substrings the anchored DFA accepts,
+    // with their occurrence counts, in byte order. Branches where the DFA
+    // dies, or that were already found to lead to no match, are pruned.
+    std::vector<SubstringMatch> matches(const DFA& dfa, size_t limit = 1000) const;
+
+    size_t size() const { return counts_.size(); }
+    size_t edge_count() const { return targets_.size(); }
+    size_t memory_usage() const;
+
+private:
+    std::vector<uint32_t> begin_;
+    std::vector<uint8_t> labels_;
+    std::vector<StateId> targets_;
+    std::vector<uint32_t> counts_;
+};
+
+}
+
+#endif
@@ -0,0 +1,323 @@
+#include "trigram.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <set>
+
+namespace fsa {
+
+namespace {
+
+// Exact, prefix and suffix sets are abandoned past this many strings.
+constexpr size_t MAX_SET = 16;
+// Byte sets up to this size are expanded into exact strings.
+constexpr size_t MAX_CLASS = 4;
+
+using StringSet = std::set<std::string>;
+
+uint32_t pack(std::string_view trigram){
+    return static_cast<uint32_t>(static_cast<unsigned char>(trigram[0])) << 16
+         | static_cast<uint32_t>(static_cast<unsigned char>(trigram[1])) << 8
+         | static_cast<unsigned char>(trigram[2]);
+}
+
+StringSet cross(const StringSet& a, const StringSet& b){
+    StringSet out;
+    for(const std::string& x : a){
+        for(const std::string& y : b) out.insert(x + y);
+    }
+    return out;
+}
+
+// Keeps the first (or last) two bytes of each string: enough to form
+// trigrams across a concatenation. Gives up, leaving {""}, if the set
+// stays too large.
+StringSet trim(const StringSet& set, bool keep_front){
+    for(size_t length = 2; ; length--){
+        StringSet out;
+        for(const std::string& s : set){
+            if(s.size() <= length) out.insert(s);
+            else out.insert(keep_front ? s.substr(0, length) : s.substr(s.size() - length));
+        }
+        if(out.size() <= MAX_SET) return out;
+        if(length == 0) return {""};
+    }
+}
+
+TrigramQuery any_of(const StringSet& strings){
+    TrigramQuery q = TrigramQuery::none();
+    for(const std::string& s : strings) q = TrigramQuery::either(std::move(q), TrigramQuery::substring(s));
+    return q;
+}
+
+struct Info {
+    bool can_empty = false;
+    bool exact_known = false;
+    StringSet exact;
+    StringSet prefix{""};
+    StringSet suffix{""};
+    TrigramQuery match;
+
+    // Exact strings too many to carry on: fold them into the other parts.
+    void forget_exact(){
+        if(!exact_known) return;
+        match = TrigramQuery::both(std::move(match), any_of(exact));
+        prefix = trim(exact, true);
+        suffix = trim(exact, false);
+        exact_known = false;
+        exact.clear();
+    }
+};
+
+Info exact_info(StringSet strings){
+    Info info;
+    info.exact_known = true;
+    info.can_empty = strings.count("") > 0;
+    info.exact = std::move(strings);
+    info.prefix = trim(info.exact, true);
+    info.suffix = trim(info.exact, false);
+    if(info.exact.size() > MAX_SET) info.forget_exact();
+    return info;
+}
+
+Info anything(bool can_empty){
+    Info info;
+    info.can_empty = can_empty;
+    return info;
+}
+
+Info concat(Info x, Info y){
+    Info info;
+    info.can_empty = x.can_empty && y.can_empty;
+    if(x.exact_known && y.exact_known && x.exact.size() * y.exact.size() <= MAX_SET){
+        info = exact_info(cross(x.exact, y.exact));
+        info.match = TrigramQuery::both(std::move(info.match), TrigramQuery::both(std::move(x.match), std::move(y.match)));
+        return info;
+    }
+    info.prefix = x.exact_known ? trim(cross(x.exact, y.prefix), true) : x.prefix;
+    info.suffix = y.exact_known ? trim(cross(x.suffix, y.exact), false) : y.suffix;
+    if(x.can_empty) info.prefix.insert(y.prefix.begin(), y.prefix.end());
+    if(y.can_empty) info.suffix.insert(x.suffix.begin(), x.suffix.end());
+    if(info.prefix.size() > MAX_SET) info.prefix = trim(info.prefix, true);
+    if(info.suffix.size() > MAX_SET) info.suffix = trim(info.suffix, false);
+    x.forget_exact();
+    y.forget_exact();
+    // Trigrams spanning the boundary.
+    TrigramQuery join = any_of(cross(x.suffix, y.prefix));
+    info.match = TrigramQuery::both(TrigramQuery::both(std::move(x.match), std::move(y.match)), std::move(join));
+    return info;
+}
+
+Info alternate(Info x, Info y){
+    Info info;
+    info.can_empty = x.can_empty || y.can_empty;
+    if(x.exact_known && y.exact_known){
+        StringSet all = x.exact;
+        all.insert(y.exact.begin(), y.exact.end());
+        info = exact_info(std::move(all));
+        info.match = TrigramQuery::both(std::move(info.match), TrigramQuery::either(std::move(x.match), std::move(y.match)));
+        return info;
+    }
+    x.forget_exact();
+    y.forget_exact();
+    info.prefix = x.prefix;
+    info.prefix.insert(y.prefix.begin(), y.prefix.end());
+    info.suffix = x.suffix;
+    info.suffix.insert(y.suffix.begin(), y.suffix.end());
+    if(info.prefix.size() > MAX_SET) info.prefix = trim(info.prefix, true);
+    if(info.suffix.size() > MAX_SET) info.suffix = trim(info.suffix, false);
+    info.match = TrigramQuery::either(std::move(x.match), std::move(y.match));
+    return info;
+}
+
+Info analyze(const Regex& regex){
+    switch(regex.kind){
+    case Regex::Kind::Empty:
+        return exact_info({""});
+    case Regex::Kind::Bytes: {
+        if(regex.bytes.none()){
+            Info info;
+            info.match = TrigramQuery::none();
+            return info;
+        }
+        if(regex.bytes.count() > MAX_CLASS) return anything(false);
+        StringSet strings;
+        for(int c = 0; c < 256; c++){
+            if(regex.bytes.test(c)) strings.insert(std::string(1, static_cast<char>(c)));
+        }
+        return exact_info(std::move(strings));
+    }
+    case Regex::Kind::Concat: {
+        Info info = analyze(regex.children[0]);
+        for(size_t i = 1; i < regex.children.size(); i++) info = concat(std::move(info), analyze(regex.children[i]));
+        return info;
+    }
+    case Regex::Kind::Alternate: {
+        Info info = analyze(regex.children[0]);
+        for(size_t i = 1; i < regex.children.size(); i++) info = alternate(std::move(info), analyze(regex.children[i]));
+        return info;
+    }
+    case Regex::Kind::Repeat: {
+        const Regex& child = regex.children[0];
+        if(regex.max == 0) return exact_info({""});
+        if(regex.min == 0){
+            if(regex.max == 1) return alternate(analyze(child), exact_info({""}));
+            return anything(true);
+        }
+        // x{m,n} with m >= 1: x, then whatever the remaining copies add.
+        Info first = analyze(child);
+        if(regex.min == regex.max && regex.min <= 3){
+            Info info = first;
+            for(int i = 1; i < regex.min; i++) info = concat(std::move(info), first);
+            return info;
+        }
+        Info rest = anything(first.can_empty);
+        Info info = concat(first, std::move(rest));
+        // The last copy ends the match, so its suffixes hold too.
+        Info last = first;
+        last.forget_exact();
+        info.suffix = last.suffix;
+        return info;
+    }
+    }
+    return anything(true);
+}
+
+void collect(const TrigramQuery& q, TrigramQuery::Op op, TrigramQuery& into){
+    // Flattens nested operands of the same operator into `into`.
+    if(q.op == op){
+        into.trigrams.insert(into.trigrams.end(), q.trigrams.begin(), q.trigrams.end());
+        for(const TrigramQuery& child : q.children) collect(child, op, into);
+    }else{
+        into.children.push_back(q);
+    }
+}
+
+TrigramQuery combine(TrigramQuery a, TrigramQuery b, TrigramQuery::Op op){
+    TrigramQuery q;
+    q.op = op;
+    collect(a, op, q);
+    collect(b, op, q);
+    std::sort(q.trigrams.begin(), q.trigrams.end());
+    q.trigrams.erase(std::unique(q.trigrams.begin(), q.trigrams.end()), q.trigrams.end());
+    if(q.trigrams.empty() && q.children.size() == 1) return std::move(q.children[0]);
+    return q;
+}
+
+std::vector<uint32_t> intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b){
+    std::vector<uint32_t> out;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    return out;
+}
+
+std::vector<uint32_t> unite(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b){
+    std::vector<uint32_t> out;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    return out;
+}
+
+}
+
+TrigramQuery TrigramQuery::substring(std::string_view text){
+    TrigramQuery q;
+    if(text.size() < 3) return q;
+    q.op = Op::And;
+    for(size_t i = 0; i + 3 <= text.size(); i++) q.trigrams.emplace_back(text.substr(i, 3));
+    std::sort(q.trigrams.begin(), q.trigrams.end());
+    q.trigrams.erase(std::unique(q.trigrams.begin(), q.trigrams.end()), q.trigrams.end());
+    return q;
+}
+
+TrigramQuery TrigramQuery::both(TrigramQuery a, TrigramQuery b){
+    if(a.op == Op::None || b.op == Op::All) return a;
+    if(b.op == Op::None || a.op == Op::All) return b;
+    return combine(std::move(a), std::move(b), Op::And);
+}
+
+TrigramQuery TrigramQuery::either(TrigramQuery a, TrigramQuery b){
+    if(a.op == Op::All || b.op == Op::None) return a;
+    if(b.op == Op::All || a.op == Op::None) return b;
+    return combine(std::move(a), std::move(b), Op::Or);
+}
+
+std::string TrigramQuery::to_string() const {
+    switch(op){
+    case Op::All: return "+";
+    case Op::None: return "-";
+    default: break;
+    }
+    std::string out;
+    const char* separator = op == Op::And ? " " : " | ";
+    auto add = [&](const std::string& part){
+        if(!out.empty()) out += separator;
+        out += part;
+    };
+    for(const std::string& t : trigrams) add("\"" + t + "\"");
+    for(const TrigramQuery& child : children) add("(" + child.to_string() + ")");
+    return out;
+}
+
+TrigramQuery trigram_query(const Regex& regex){
+    Info info = analyze(regex);
+    info.forget_exact();
+    return info.match;
+}
+
+TrigramQuery trigram_query(std::string_view pattern){
+    return trigram_query(parse(pattern));
+}
+
+uint32_t TrigramIndex::add(std::string_view document){
+    uint32_t id = documents_++;
+    std::vector<uint32_t> seen;
+    for(size_t i = 0; i + 3 <= document.size(); i++) seen.push_back(pack(document.substr(i, 3)));
+    std::sort(seen.begin(), seen.end());
+    seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+    for(uint32_t t : seen) postings_[t].push_back(id);
+    return id;
+}
+
+std::vector<uint32_t> TrigramIndex::candidates(const TrigramQuery& query) const {
+    std::vector<uint32_t> all(documents_);
+    switch(query.op){
+    case TrigramQuery::Op::All:
+        std::iota(all.begin(), all.end(), 0);
+        return all;
+    case TrigramQuery::Op::None:
+        return {};
+    case TrigramQuery::Op::And: {
+        std::iota(all.begin(), all.end(), 0);
+        std::vector<uint32_t> result = std::move(all);
+        for(const std::string& t : query.trigrams){
+            auto it = postings_.find(pack(t));
+            if(it == postings_.end()) return {};
+            result = intersect(result, it->second);
+            if(result.empty()) return result;
+        }
+        for(const TrigramQuery& child : query.children){
+            result = intersect(result, candidates(child));
+            if(result.empty()) return result;
+        }
+        return result;
+    }
+    case TrigramQuery::Op::Or: {
+        std::vector<uint32_t> result;
+        for(const std::string& t : query.trigrams){
+            auto it = postings_.find(pack(t));
+            if(it != postings_.end()) result = unite(result, it->second);
+        }
+        for(const TrigramQuery& child : query.children) result = unite(result, candidates(child));
+        return result;
+    }
+    }
+    return {};
+}
+
+size_t TrigramIndex::memory_usage() const {
+    size_t bytes = 0;
+    for(const auto& entry : postings_) bytes += sizeof(entry) + entry.second.size() * sizeof(uint32_t);
+    return bytes;
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef FSA_TRIGRAM_H
+#define FSA_TRIGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "regex.h"
+
+namespace fsa {
+
+// Boolean query over trigrams a document must contain for a regex to be
+// able to match in it. All is true for every document, None for none.
+struct TrigramQuery {
+    enum class Op { All, None, And, Or };
+
+    Op op = Op::All;
+    std::vector<std::string> trigrams;      // And, Or: leaf operands
+    std::vector<TrigramQuery> children;     // And, Or: nested operands
+
+    static TrigramQuery all(){ return {}; }
+    static TrigramQuery none(){ TrigramQuery q; q.op = Op::None; return q; }
+    // Every trigram of `text`; All if it is shorter than three bytes.
+    static TrigramQuery substring(std::string_view text);
+    static TrigramQuery both(TrigramQuery a, TrigramQuery b);
+    static TrigramQuery either(TrigramQuery a, TrigramQuery b);
+
+    // e.g. ("abc" "bcd") | "xyz", with And written as juxtaposition.
+    std::string to_string() const;
+};
+
+// Computes the trigram query for a regex, following the approach of Google
+// Code Search: per node it tracks whether the node can match empty, its
+// exact strings when there are few, and the possible prefixes and
+// suffixes, and joins them across concatenations. The query is implied by
+// any unanchored match, so documents failing it can be skipped.
+TrigramQuery trigram_query(const Regex& regex);
+TrigramQuery trigram_query(std::string_view pattern);
+
+// Posting lists from trigram to the sorted ids of the documents holding
+// it, for ruling documents out before running an automaton over them.
+class TrigramIndex {
+public:
+    // Indexes a document; ids count up from 0.
+    uint32_t add(std::string_view document);
+
+    // Sorted ids of the documents the query does not rule out.
+    std::vector<uint32_t> candidates(const TrigramQuery& query) const;
+
+    size_t size() const { return documents_; }
+    size_t trigram_count() const { return postings_.size(); }
+    size_t memory_usage() const;
+
+private:
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+    uint32_t documents_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,376 @@
+#include "uring_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "stream.h"
+
+namespace fsa {
+
+namespace {
+
+[[noreturn]] void throw_errno(const char* what){
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Just enough of io_uring for reads: the raw syscalls and ring mappings,
+// since liburing is not a dependency.
+class Ring {
+public:
+    explicit Ring(unsigned entries){
+        io_uring_params p{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if(fd_ < 0) throw_errno("io_uring_setup");
+        sq_entries_ = p.sq_entries;
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        single_ = p.features & IORING_FEAT_SINGLE_MMAP;
+        if(single_) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        sq_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ = single_ ? sq_ : map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+        char* sq = static_cast<char*>(sq_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        char* cq = static_cast<char*>(cq_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        tail_ = *sq_tail_;
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring(){
+        if(sqes_) ::munmap(sqes_, sqes_size_);
+        if(cq_ && !single_) ::munmap(cq_, cq_size_);
+        if(sq_) ::munmap(sq_, sq_size_);
+        ::close(fd_);
+    }
+
+    bool register_buffers(const iovec* buffers, unsigned count){
+        return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+    }
+
+    // Next free submission entry, zeroed, or nullptr if the queue is full.
+    io_uring_sqe* next(){
+        unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if(tail_ - head >= sq_entries_) return nullptr;
+        unsigned index = tail_ & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        tail_++;
+        pending_++;
+        return sqe;
+    }
+
+    // Submits queued entries and waits for at least `wait` completions.
+    void enter(unsigned wait){
+        __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+        if(pending_ == 0 && wait == 0) return;
+        int n = static_cast<int>(::syscall(__NR_io_uring_enter, fd_, pending_, wait,
+                                           wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+        if(n < 0){
+            if(errno == EINTR || errno == EAGAIN || errno == EBUSY) return;
+            throw_errno("io_uring_enter");
+        }
+        pending_ -= static_cast<unsigned>(n);
+    }
+
+    bool pop(io_uring_cqe& out){
+        unsigned head = *cq_head_;
+        if(head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return false;
+        out = cqes_[head & cq_mask_];
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    void* map(size_t size, off_t offset){
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if(p == MAP_FAILED) throw_errno("io_uring mmap");
+        return p;
+    }
+
+    int fd_;
+    bool single_ = false;
+    void* sq_ = nullptr;
+    void* cq_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+    unsigned tail_ = 0;
+    unsigned pending_ = 0;
+};
+
+struct File {
+    explicit File(const BundleView& rules) : matcher(rules){}
+
+    int fd = -1;
+    bool opened = false;
+    uint32_t total = 0;       // chunks in the file
+    uint32_t submitted = 0;   // chunks read or being read
+    uint32_t dispatched = 0;  // chunks handed to the worker, in order
+    uint32_t returned = 0;    // chunks the worker is done with
+    std::map<uint32_t, unsigned> ready;   // read, waiting for earlier chunks
+    std::atomic<bool> stop{false};
+    StreamMatcher<BundleView> matcher;
+    int error = 0;
+};
+
+struct Buffer {
+    char* data;
+    size_t file;
+    uint32_t chunk;
+    uint64_t offset;
+    size_t length;
+    size_t filled;
+};
+
+// Buffer indices passed between threads.
+class Queue {
+public:
+    void push(unsigned buffer){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.push_back(buffer);
+        }
+        ready_.notify_one();
+    }
+
+    void close(){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+    // Blocks until an item arrives; false once closed and drained.
+    bool pop(unsigned& buffer){
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]{ return closed_ || !items_.empty(); });
+        if(items_.empty()) return false;
+        buffer = items_.front();
+        items_.pop_front();
+        return true;
+    }
+
+    void drain(std::deque<unsigned>& out, bool wait){
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(wait) ready_.wait(lock, [this]{ return !items_.empty(); });
+        while(!items_.empty()){
+            out.push_back(items_.front());
+            items_.pop_front();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<unsigned> items_;
+    bool closed_ = false;
+};
+
+}
+
+std::vector<FileMatches> scan_files_uring(const BundleView& rules, const std::vector<std::string>& paths,
+                                          const UringScanOptions& options){
+    const size_t page = 4096;
+    size_t chunk_size = std::max(page, (options.chunk_size + page - 1) / page * page);
+    unsigned buffer_count = std::max(1u, options.buffers);
+    unsigned worker_count = options.workers ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+
+    Ring ring(buffer_count);
+    std::unique_ptr<char, decltype(&std::free)> memory(
+        static_cast<char*>(std::aligned_alloc(page, chunk_size * buffer_count)), &std::free);
+    if(!memory) throw std::bad_alloc();
+    std::vector<Buffer> buffers(buffer_count);
+    std::vector<iovec> iovecs(buffer_count);
+    std::vector<unsigned> free_buffers;
+    for(unsigned i = 0; i < buffer_count; i++){
+        buffers[i].data = memory.get() + i * chunk_size;
+        iovecs[i] = {buffers[i].data, chunk_size};
+        free_buffers.push_back(i);
+    }
+    // Registration can fail under a low RLIMIT_MEMLOCK; plain reads still work.
+    bool fixed = ring.register_buffers(iovecs.data(), buffer_count);
+
+    std::vector<std::unique_ptr<File>> files;
+    for(size_t i = 0; i < paths.size(); i++) files.push_back(std::make_unique<File>(rules));
+    std::vector<FileMatches> results(paths.size());
+
+    std::vector<Queue> work(worker_count);
+    Queue returned;
+    std::vector<std::thread> workers;
+    for(unsigned w = 0; w < worker_count; w++){
+        workers.emplace_back([&, w]{
+            unsigned b;
+            while(work[w].pop(b)){
+                const Buffer& buf = buffers[b];
+                File& f = *files[buf.file];
+                if(!f.stop.load(std::memory_order_acquire)){
+                    f.matcher.feed(std::string_view(buf.data, buf.filled));
+                    if(f.matcher.done()) f.stop.store(true, std::memory_order_release);
+                }
+                returned.push(b);
+            }
+        });
+    }
+
+    size_t remaining = paths.size();
+    auto finish = [&](size_t i){
+        File& f = *files[i];
+        if(f.fd >= 0) ::close(f.fd);
+        f.fd = -1;
+        results[i].matches = f.matcher.matches();
+        results[i].error = f.error;
+        remaining--;
+    };
+    auto maybe_finish = [&](size_t i){
+        File& f = *files[i];
+        if(f.fd >= 0 && (f.stop || f.submitted == f.total) && f.returned == f.submitted) finish(i);
+    };
+    auto submit_read = [&](unsigned b){
+        Buffer& buf = buffers[b];
+        io_uring_sqe* sqe = ring.next();
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = files[buf.file]->fd;
+        sqe->off = buf.offset + buf.filled;
+        sqe->addr = reinterpret_cast<uint64_t>(buf.data + buf.filled);
+        sqe->len = static_cast<uint32_t>(buf.length - buf.filled);
+        sqe->buf_index = fixed ? static_cast<uint16_t>(b) : 0;
+        sqe->user_data = b;
+    };
+
+    size_t cursor = 0;
+    unsigned in_flight = 0;
+    std::deque<unsigned> done;
+    try{
+        while(remaining > 0){
+            // Take back buffers the workers are finished with.
+            returned.drain(done, false);
+            for(unsigned b : done){
+                File& f = *files[buffers[b].file];
+                f.returned++;
+                free_buffers.push_back(b);
+                maybe_finish(buffers[b].file);
+            }
+            done.clear();
+
+            // Keep every free buffer busy, reading ahead in the current file.
+            while(!free_buffers.empty() && cursor < files.size()){
+                File& f = *files[cursor];
+                if(!f.opened){
+                    f.opened = true;
+                    f.fd = ::open(paths[cursor].c_str(), O_RDONLY | O_CLOEXEC);
+                    struct stat st;
+                    if(f.fd < 0 || ::fstat(f.fd, &st) != 0){
+                        f.error = errno;
+                        finish(cursor++);
+                        continue;
+                    }
+                    f.total = static_cast<uint32_t>((static_cast<uint64_t>(st.st_size) + chunk_size - 1) / chunk_size);
+                    if(f.matcher.done()) f.stop = true;
+                    maybe_finish(cursor);
+                }
+                if(f.stop || f.submitted == f.total){
+                    cursor++;
+                    continue;
+                }
+                unsigned b = free_buffers.back();
+                free_buffers.pop_back();
+                Buffer& buf = buffers[b];
+                buf.file = cursor;
+                buf.chunk = f.submitted++;
+                buf.offset = static_cast<uint64_t>(buf.chunk) * chunk_size;
+                buf.length = chunk_size;
+                buf.filled = 0;
+                submit_read(b);
+                in_flight++;
+            }
+
+            if(in_flight == 0){
+                if(remaining > 0) returned.drain(done, true);
+                continue;
+            }
+            ring.enter(1);
+
+            io_uring_cqe cqe;
+            while(ring.pop(cqe)){
+                in_flight--;
+                unsigned b = static_cast<unsigned>(cqe.user_data);
+                Buffer& buf = buffers[b];
+                File& f = *files[buf.file];
+                if(cqe.res < 0){
+                    f.error = -cqe.res;
+                    f.stop = true;
+                }else if(cqe.res > 0){
+                    buf.filled += static_cast<size_t>(cqe.res);
+                    if(buf.filled < buf.length && !f.stop){
+                        // Short read before the end of the chunk: read the rest.
+                        submit_read(b);
+                        in_flight++;
+                        continue;
+                    }
+                }
+                // res == 0 is end of file: the last chunk is short.
+                f.ready[buf.chunk] = b;
+                auto it = f.ready.find(f.dispatched);
+                while(it != f.ready.end()){
+                    work[buf.file % worker_count].push(it->second);
+                    f.ready.erase(it);
+                    f.dispatched++;
+                    it = f.ready.find(f.dispatched);
+                }
+            }
+        }
+    }catch(...){
+        for(Queue& q : work) q.close();
+        for(std::thread& t : workers) t.join();
+        for(auto& f : files){
+            if(f->fd >= 0) ::close(f->fd);
+        }
+        throw;
+    }
+    for(Queue& q : work) q.close();
+    for(std::thread& t : workers) t.join();
+    return results;
+}
+
+}
@@ -0,0 +1,40 @@
+#ifndef FSA_URING_SCAN_H
+#define FSA_URING_SCAN_H
+
+#include <string>
+#include <vector>
+
+#include "bundle.h"
+
+namespace fsa {
+
+struct UringScanOptions {
+    // Bytes per read; each read lands in one registered buffer.
+    size_t chunk_size = 1 << 20;
+    // Registered buffers, which bounds the reads in flight plus the chunks
+    // waiting for or being scanned.
+    unsigned buffers = 16;
+    // Scanning threads; 0 picks one per hardware thread.
+    unsigned workers = 0;
+};
+
+struct FileMatches {
+    std::vector<PatternId> matches;
+    int error = 0;   // errno from opening or reading, 0 on success
+};
+
+// Scans whole files through a Linux io_uring pipeline. One thread keeps up
+// to `buffers` fixed-buffer reads in flight, several on the same file when
+// it is large, and hands completed chunks in file order to the worker that
+// owns the file. Workers feed a StreamMatcher per file, so I/O overlaps
+// scanning and different files scan in parallel. A file stops being read
+// once its result cannot change.
+//
+// Result i belongs to paths[i]. Throws std::system_error if io_uring is not
+// available (old kernel, seccomp); callers fall back to mapped reads.
+std::vector<FileMatches> scan_files_uring(const BundleView& rules, const std::vector<std::string>& paths,
+                                          const UringScanOptions& options = {});
+
+}
+
+#endif
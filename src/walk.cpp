@@ -0,0 +1,271 @@
+#include "walk.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "compile.h"
+#include "glob.h"
+#include "rules.h"
+
+namespace fsa {
+
+IgnoreRules::IgnoreRules(const std::vector<std::string>& lines){
+    NFA nfa;
+    for(std::string rule : lines){
+        // Trailing spaces are dropped unless escaped.
+        while(!rule.empty() && rule.back() == ' ' && !(rule.size() > 1 && rule[rule.size() - 2] == '\\')) rule.pop_back();
+        bool negated = !rule.empty() && rule[0] == '!';
+        if(negated) rule.erase(0, 1);
+        if(!rule.empty() && rule[0] == '\\' && rule.size() > 1 && (rule[1] == '#' || rule[1] == '!')) rule.erase(0, 1);
+        bool directory_only = !rule.empty() && rule.back() == '/';
+        if(directory_only) rule.pop_back();
+        if(rule.empty()) continue;
+        // Without an inner slash the rule matches a name at any depth.
+        if(rule.find('/') == std::string::npos) rule.insert(0, "**/");
+        else if(rule[0] == '/') rule.erase(0, 1);
+        Regex regex;
+        try{
+            GlobOptions glob;
+            glob.braces = false;
+            regex = parse_glob(rule, glob);
+        }catch(const ParseError&){
+            continue;
+        }
+        nfa.add(regex);
+        negated_.push_back(negated);
+        directory_only_.push_back(directory_only);
+    }
+    if(nfa.pattern_count() == 0) return;
+    CompileOptions options;
+    options.anchored = true;
+    dfa_ = compile(nfa, options);
+}
+
+IgnoreRules::Verdict IgnoreRules::check(std::string_view path, bool directory) const {
+    if(empty()) return Verdict::None;
+    StateId s = dfa_.start();
+    for(unsigned char c : path){
+        s = dfa_.next(s, c);
+        if(s == DFA::DEAD) return Verdict::None;
+    }
+    const std::vector<PatternId>& rules = dfa_.matches(s);
+    for(auto it = rules.rbegin(); it != rules.rend(); ++it){
+        if(directory_only_[*it] && !directory) continue;
+        return negated_[*it] ? Verdict::Keep : Verdict::Ignore;
+    }
+    return Verdict::None;
+}
+
+namespace {
+
+// The ignore rules in effect in a directory: its own .gitignore, then
+// those of its parents. Paths are matched relative to `base`, the length
+// of the directory's prefix in every path below it.
+struct Scope {
+    std::shared_ptr<const Scope> parent;
+    size_t base;
+    IgnoreRules rules;
+};
+
+bool ignored(const Scope* scope, const std::string& path, bool directory){
+    for(; scope; scope = scope->parent.get()){
+        IgnoreRules::Verdict verdict = scope->rules.check(std::string_view(path).substr(scope->base), directory);
+        if(verdict != IgnoreRules::Verdict::None) return verdict == IgnoreRules::Verdict::Ignore;
+    }
+    return false;
+}
+
+struct Directory {
+    std::string path;     // as passed to open()
+    std::string prefix;   // prepended to entry names: "" below ".", else path + "/"
+    std::shared_ptr<const Scope> scope;
+};
+
+struct Entry {
+    std::string name;
+    unsigned char type;
+};
+
+// Raw getdents64 layout; glibc only wraps it in recent versions.
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+std::string error_text(const std::string& path, int error){
+    return path + ": " + std::strerror(error);
+}
+
+bool read_entries(int fd, std::vector<Entry>& entries){
+    alignas(LinuxDirent64) char buffer[1 << 15];
+    while(true){
+        long n = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if(n < 0) return false;
+        if(n == 0) return true;
+        for(long offset = 0; offset < n;){
+            const LinuxDirent64* d = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+            offset += d->d_reclen;
+            if(std::strcmp(d->d_name, ".") == 0 || std::strcmp(d->d_name, "..") == 0) continue;
+            entries.push_back({d->d_name, d->d_type});
+        }
+    }
+}
+
+std::string read_file_at(int dir, const char* name){
+    std::string content;
+    int fd = ::openat(dir, name, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return content;
+    char buffer[1 << 14];
+    ssize_t n;
+    while((n = ::read(fd, buffer, sizeof(buffer))) > 0) content.append(buffer, static_cast<size_t>(n));
+    ::close(fd);
+    return content;
+}
+
+class Walker {
+public:
+    explicit Walker(const WalkOptions& options) : options_(options){}
+
+    void add(Directory directory){
+        pending_.push_back(std::move(directory));
+    }
+
+    void add_file(std::string path){
+        files_.push_back(std::move(path));
+    }
+
+    void add_error(std::string message){
+        std::lock_guard<std::mutex> lock(mutex_);
+        errors_.push_back(std::move(message));
+    }
+
+    void run(){
+        unsigned count = options_.threads ? options_.threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> threads;
+        for(unsigned i = 0; i < count; i++) threads.emplace_back([this]{ work(); });
+        for(std::thread& t : threads) t.join();
+    }
+
+    std::vector<std::string>& files(){ return files_; }
+    std::vector<std::string>& errors(){ return errors_; }
+
+private:
+    void work(){
+        std::vector<std::string> found;
+        std::vector<Directory> children;
+        while(true){
+            Directory directory;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [this]{ return !pending_.empty() || busy_ == 0; });
+                if(pending_.empty()) break;
+                directory = std::move(pending_.back());
+                pending_.pop_back();
+                busy_++;
+            }
+            children.clear();
+            visit(directory, found, children);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for(Directory& child : children) pending_.push_back(std::move(child));
+                busy_--;
+            }
+            changed_.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        files_.insert(files_.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+
+    void visit(const Directory& directory, std::vector<std::string>& found, std::vector<Directory>& children){
+        int fd = ::open(directory.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(fd < 0){
+            add_error(error_text(directory.path, errno));
+            return;
+        }
+        std::vector<Entry> entries;
+        if(!read_entries(fd, entries)) add_error(error_text(directory.path, errno));
+
+        std::shared_ptr<const Scope> scope = directory.scope;
+        if(options_.ignore_files){
+            for(const Entry& e : entries){
+                if(e.name != ".gitignore") continue;
+                std::istringstream in(read_file_at(fd, ".gitignore"));
+                IgnoreRules rules(read_rules(in));
+                if(!rules.empty()){
+                    scope = std::make_shared<const Scope>(Scope{scope, directory.prefix.size(), std::move(rules)});
+                }
+                break;
+            }
+        }
+
+        for(const Entry& e : entries){
+            unsigned char type = e.type;
+            if(type == DT_UNKNOWN){
+                struct stat st;
+                if(::fstatat(fd, e.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_LNK;
+            }
+            std::string path = directory.prefix + e.name;
+            if(type == DT_DIR){
+                if(e.name == ".git" || ignored(scope.get(), path, true)) continue;
+                children.push_back({path, path + "/", scope});
+            }else if(type == DT_REG){
+                if(!ignored(scope.get(), path, false)) found.push_back(std::move(path));
+            }
+        }
+        ::close(fd);
+    }
+
+    const WalkOptions& options_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Directory> pending_;
+    unsigned busy_ = 0;
+    std::vector<std::string> files_;
+    std::vector<std::string> errors_;
+};
+
+}
+
+std::vector<std::string> walk_files(const std::vector<std::string>& roots, const WalkOptions& options,
+                                    std::vector<std::string>* errors){
+    Walker walker(options);
+    for(std::string root : roots){
+        while(root.size() > 1 && root.back() == '/') root.pop_back();
+        struct stat st;
+        if(::stat(root.c_str(), &st) != 0){
+            walker.add_error(error_text(root, errno));
+            continue;
+        }
+        if(!S_ISDIR(st.st_mode)){
+            walker.add_file(root);
+            continue;
+        }
+        std::string prefix = root == "." ? "" : root == "/" ? "/" : root + "/";
+        std::shared_ptr<const Scope> scope;
+        if(!options.ignore.empty()) scope = std::make_shared<const Scope>(Scope{nullptr, prefix.size(), IgnoreRules(options.ignore)});
+        walker.add({root, prefix, scope});
+    }
+    walker.run();
+    std::vector<std::string>& files = walker.files();
+    std::sort(files.begin(), files.end());
+    if(errors) errors->insert(errors->end(), walker.errors().begin(), walker.errors().end());
+    return std::move(files);
+}
+
+}
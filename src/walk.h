@@ -0,0 +1,57 @@
+#ifndef FSA_WALK_H
+#define FSA_WALK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dfa.h"
+
+namespace fsa {
+
+// The rules of one .gitignore file, compiled into a single anchored DFA
+// over paths relative to the file's directory, so a path is checked
+// against every rule in one pass. Supported: comments, '!' to re-include,
+// a trailing '/' for directories only, a leading or inner '/' to anchor at
+// the directory, and the glob syntax of parse_glob(). Malformed rules are
+// skipped.
+class IgnoreRules {
+public:
+    enum class Verdict { None, Ignore, Keep };
+
+    IgnoreRules() = default;
+    explicit IgnoreRules(const std::vector<std::string>& lines);
+
+    bool empty() const { return dfa_.size() == 0; }
+
+    // The last rule matching the path decides; None if no rule matches.
+    Verdict check(std::string_view path, bool directory) const;
+
+private:
+    DFA dfa_;
+    std::vector<bool> negated_;
+    std::vector<bool> directory_only_;
+};
+
+struct WalkOptions {
+    // Directory-reading threads; 0 picks one per hardware thread.
+    unsigned threads = 0;
+    // Honor .gitignore files in every directory walked.
+    bool ignore_files = true;
+    // Extra rules in .gitignore syntax, applied as if read from a
+    // .gitignore at each root; .gitignore files below take precedence.
+    std::vector<std::string> ignore;
+};
+
+// Every regular file below the roots that no ignore rule excludes, sorted.
+// Directories are read in parallel with getdents64; ignored directories
+// are not entered, and .git directories and symbolic links are skipped.
+// A root that is a file is returned as is. Paths below "." are returned
+// without a "./" prefix. Errors (unreadable directories, missing roots)
+// do not stop the walk; they are appended to `errors` if given.
+std::vector<std::string> walk_files(const std::vector<std::string>& roots, const WalkOptions& options = {},
+                                    std::vector<std::string>* errors = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "xfa.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace fsa {
+
+namespace {
+
+struct Cut {
+    std::vector<Regex> segments;
+    // gaps[i] is the byte set allowed between segments[i] and [i + 1].
+    std::vector<ByteSet> gaps;
+};
+
+Cut cut(const Regex& regex){
+    Cut result;
+    if(regex.kind != Regex::Kind::Concat){
+        result.segments.push_back(regex);
+        return result;
+    }
+    std::vector<Regex> current;
+    ByteSet gap;
+    bool in_gap = false;
+    bool leading = true;
+    auto close_segment = [&](){
+        Regex segment = Regex::concat(std::move(current));
+        current.clear();
+        if(result.segments.empty()){
+            result.segments.push_back(std::move(segment));
+            return;
+        }
+        int length = fixed_length(segment);
+        if(length > 0 && (bytes_used(segment) & ~gap).none()){
+            result.gaps.push_back(gap);
+            result.segments.push_back(std::move(segment));
+            return;
+        }
+        // Cannot test this cut exactly: keep the gap inside the DFA. The
+        // merged segment no longer has a fixed length, so if it was cut off
+        // from the one before, that cut is undone too, back to a segment
+        // that can still be tested (in the end, the first one).
+        auto merge = [&](Regex tail, const ByteSet& before){
+            Regex merged = Regex::concat({std::move(result.segments.back()),
+                                          Regex::repeat(Regex::byte_set(before), 0, Regex::UNBOUNDED),
+                                          std::move(tail)});
+            result.segments.back() = std::move(merged);
+        };
+        merge(std::move(segment), gap);
+        while(result.segments.size() > 1){
+            const Regex& last = result.segments.back();
+            const ByteSet& before = result.gaps.back();
+            if(fixed_length(last) > 0 && (bytes_used(last) & ~before).none()) break;
+            Regex tail = std::move(result.segments.back());
+            ByteSet tail_gap = before;
+            result.segments.pop_back();
+            result.gaps.pop_back();
+            merge(std::move(tail), tail_gap);
+        }
+    };
+    for(const Regex& part : regex.children){
+        bool wide = is_wide_repeat(part) && part.min == 0;
+        if(wide && leading) continue;
+        if(wide){
+            gap = in_gap ? (gap & part.children[0].bytes) : part.children[0].bytes;
+            in_gap = true;
+            continue;
+        }
+        if(in_gap){
+            close_segment();
+            in_gap = false;
+        }
+        leading = false;
+        current.push_back(part);
+    }
+    // A trailing wide repeat never changes whether an unanchored search
+    // matches, so it is dropped along with its gap.
+    close_segment();
+    return result;
+}
+
+}
+
+XFA::XFA(const std::vector<std::string>& patterns, const CompileOptions& options)
+    : patterns_(patterns.size()){
+    if(options.anchored) throw std::invalid_argument("XFA only supports unanchored search");
+    NFA nfa;
+    for(size_t i = 0; i < patterns.size(); i++){
+        Cut c = cut(parse(patterns[i]));
+        for(size_t k = 0; k < c.segments.size(); k++){
+            Segment segment;
+            segment.pattern = static_cast<PatternId>(i);
+            if(k > 0){
+                int length = fixed_length(c.segments[k]);
+                assert(length >= 0);
+                segment.test = static_cast<uint32_t>(variables_ - 1);
+                segment.length = static_cast<uint32_t>(length);
+            }
+            if(k + 1 < c.segments.size()){
+                segment.set = static_cast<uint32_t>(variables_++);
+                const ByteSet& gap = c.gaps[k];
+                for(int b = 0; b < 256; b++){
+                    if(!gap.test(b)) clears_[b].push_back(segment.set);
+                }
+            }
+            nfa.add(c.segments[k]);
+            segments_.push_back(segment);
+        }
+    }
+    dfa_ = compile(nfa, options);
+}
+
+size_t XFA::memory_usage() const {
+    size_t bytes = dfa_.memory_usage() + segments_.size() * sizeof(Segment);
+    for(const auto& list : clears_) bytes += sizeof(list) + list.size() * sizeof(uint32_t);
+    return bytes;
+}
+
+std::vector<PatternId> XFA::match_set(std::string_view text) const {
+    constexpr uint64_t UNSET = UINT64_MAX;
+    std::vector<uint64_t> variables(variables_, UNSET);
+    std::vector<bool> found(patterns_, false);
+    size_t remaining = patterns_;
+
+    // `end` is the offset just past the byte that completed the match.
+    auto run = [&](StateId s, uint64_t end){
+        for(PatternId id : dfa_.matches(s)){
+            const Segment& seg = segments_[id];
+            if(found[seg.pattern]) continue;
+            if(seg.test != NONE){
+                uint64_t since = variables[seg.test];
+                if(since == UNSET || since + seg.length > end) continue;
+            }
+            if(seg.set == NONE){
+                found[seg.pattern] = true;
+                remaining--;
+            }else if(variables[seg.set] == UNSET){
+                variables[seg.set] = end;
+            }
+        }
+    };
+
+    StateId s = dfa_.start();
+    if(s == DFA::DEAD) return {};
+    if(dfa_.accepting(s)) run(s, 0);
+    for(size_t i = 0; i < text.size() && remaining > 0; i++){
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        for(uint32_t v : clears_[c]) variables[v] = UNSET;
+        s = dfa_.next(s, c);
+        if(dfa_.accepting(s)) run(s, i + 1);
+    }
+
+    std::vector<PatternId> result;
+    for(PatternId p = 0; p < patterns_; p++){
+        if(found[p]) result.push_back(p);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef FSA_XFA_H
+#define FSA_XFA_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compile.h"
+#include "dfa.h"
+
+namespace fsa {
+
+// Extended finite automaton for unanchored multi-pattern search. A pattern
+// like `A.*B.*C` is cut at its wide repeats into segments A, B and C; the
+// segments of every pattern share one DFA, and the order between them is
+// tracked in auxiliary variables instead of in DFA states. Each variable
+// records where the previous segment first ended since the gap was last
+// broken: a segment match tests its variable, and if the previous segment
+// ended before it started, sets the next one. Bytes outside a gap's set
+// (the newline for `.*`) clear the variables of that gap.
+//
+// A cut is only made where the next segment has a fixed length and uses
+// only bytes the gap allows, which is what makes the position test exact;
+// otherwise the two segments stay together in the DFA.
+class XFA {
+public:
+    // Pattern i reports PatternId i. Throws std::invalid_argument if
+    // options.anchored is set.
+    explicit XFA(const std::vector<std::string>& patterns, const CompileOptions& options = {});
+
+    const DFA& automaton() const { return dfa_; }
+    size_t variable_count() const { return variables_; }
+    size_t pattern_count() const { return patterns_; }
+    size_t memory_usage() const;
+
+    // Every pattern that matches somewhere in `text`, sorted.
+    std::vector<PatternId> match_set(std::string_view text) const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Action run when a segment's DFA match id is reported.
+    struct Segment {
+        PatternId pattern;
+        uint32_t test = NONE;   // variable the previous segment set
+        uint32_t set = NONE;    // variable for the next segment, NONE if last
+        uint32_t length = 0;    // fixed length, used with `test`
+    };
+
+    DFA dfa_;
+    std::vector<Segment> segments_;
+    std::array<std::vector<uint32_t>, 256> clears_;
+    size_t variables_ = 0;
+    size_t patterns_;
+};
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+// Binary escapes and length-prefixed groups.
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "check.h"
+#include "compile.h"
+
+namespace {
+
+// Compiles each pattern once; counted groups make sizable automata.
+bool anchored_accepts(const std::string& pattern, std::string_view value){
+    static std::map<std::string, fsa::DFA> compiled;
+    auto it = compiled.find(pattern);
+    if(it == compiled.end()){
+        fsa::CompileOptions options;
+        options.anchored = true;
+        it = compiled.emplace(pattern, fsa::compile(pattern, options)).first;
+    }
+    return it->second.accepts(value);
+}
+
+bool parse_fails(const char* pattern){
+    try{
+        fsa::parse(pattern);
+    }catch(const fsa::ParseError&){
+        return true;
+    }
+    return false;
+}
+
+std::string bytes(std::initializer_list<int> values){
+    std::string s;
+    for(int v : values) s += static_cast<char>(v);
+    return s;
+}
+
+void check_escapes(){
+    CHECK(anchored_accepts("a\\Cb", "a\nb"));
+    CHECK(anchored_accepts("a\\Cb", bytes({'a', 0xff, 'b'})));
+    CHECK(!anchored_accepts("a.b", "a\nb"));
+    CHECK(anchored_accepts("\\x{cafe}", "\xca\xfe"));
+    CHECK(anchored_accepts("\\x{00FF}+", bytes({0, 0xff, 0, 0xff})));
+    CHECK(!anchored_accepts("\\x{cafe}", "\xca"));
+    CHECK(parse_fails("\\x{abc}"));
+    CHECK(parse_fails("\\x{}"));
+    CHECK(parse_fails("\\x{ab"));
+    CHECK(parse_fails("\\x{zz}"));
+}
+
+void check_one_byte_lengths(){
+    CHECK(anchored_accepts("(?u8:\\C)", bytes({3, 'x', 'y', 'z'})));
+    CHECK(!anchored_accepts("(?u8:\\C)", bytes({3, 'x', 'y'})));
+    CHECK(!anchored_accepts("(?u8:\\C)", bytes({3, 'x', 'y', 'z', 'w'})));
+    CHECK(anchored_accepts("(?u8:\\C)", bytes({0})));
+    CHECK(anchored_accepts("(?u8:\\C)*", bytes({1, 'a', 0, 2, 'b', 'c'})));
+    // The count is in units of the group body.
+    CHECK(anchored_accepts("(?u8:ab)", bytes({2, 'a', 'b', 'a', 'b'})));
+    CHECK(!anchored_accepts("(?u8:ab)", bytes({2, 'a', 'b'})));
+    // A type byte, then a length-prefixed payload.
+    CHECK(anchored_accepts("\\x{01}(?u8:[a-z])\\x{ff}", bytes({1, 2, 'h', 'i', 0xff})));
+    std::string long_field = bytes({255}) + std::string(255, 'q');
+    CHECK(anchored_accepts("(?u8:\\C)", long_field));
+    CHECK(parse_fails("(?u8\\C)"));
+}
+
+void check_bounded_lengths(){
+    CHECK(anchored_accepts("(?u16be<=300:\\C)", bytes({0, 2, 'x', 'y'})));
+    CHECK(anchored_accepts("(?u16le<=300:\\C)", bytes({2, 0, 'x', 'y'})));
+    CHECK(!anchored_accepts("(?u16le<=300:\\C)", bytes({0, 2, 'x', 'y'})));
+    std::string field = bytes({0x01, 0x2c}) + std::string(300, 'q');
+    CHECK(anchored_accepts("(?u16be<=300:\\C)", field));
+    // Counts above the bound never match.
+    CHECK(!anchored_accepts("(?u16be<=300:\\C)", bytes({0x01, 0x2d}) + std::string(301, 'q')));
+    CHECK(!anchored_accepts("(?u8<=2:\\C)", bytes({3, 'x', 'y', 'z'})));
+    CHECK(anchored_accepts("(?u8<=2:\\C)", bytes({2, 'x', 'y'})));
+
+    CHECK(parse_fails("(?u16be:\\C)"));
+    CHECK(parse_fails("(?u16le:\\C)"));
+    CHECK(parse_fails("(?u16be<=5000:\\C)"));
+    CHECK(parse_fails("(?u16be<=:\\C)"));
+    CHECK(parse_fails("(?u8<=300:\\C)"));
+    CHECK(parse_fails("(?u8<=2\\C)"));
+}
+
+// Unanchored, a count could start at every byte; compile() refuses.
+void check_unanchored(){
+    bool rejected = false;
+    try{
+        fsa::compile("(?u8:\\C)");
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+    rejected = false;
+    try{
+        fsa::compile({"plain", "x(?u8<=4:ab)"});
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+    CHECK(fsa::compile("\\x{cafe}\\C").find("xx\xca\xfe\n"));
+}
+
+}
+
+int main(){
+    check_escapes();
+    check_one_byte_lengths();
+    check_bounded_lengths();
+    check_unanchored();
+    return fsa_test::finish("binary_test");
+}
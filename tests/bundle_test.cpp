@@ -0,0 +1,100 @@
+// Bundles written by write_bundle() and read back through BundleView.
+
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bundle.h"
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "rules.h"
+
+namespace {
+
+// Bundle bytes in 4-byte aligned storage, as a mapping would provide.
+std::vector<uint32_t> serialize(const fsa::DFA& dfa, size_t& size){
+    std::ostringstream out;
+    fsa::write_bundle(dfa, out);
+    std::string bytes = out.str();
+    size = bytes.size();
+    std::vector<uint32_t> words((bytes.size() + 3) / 4);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return words;
+}
+
+void check_round_trip(std::mt19937& rng, bool anchored){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    size_t size = 0;
+    std::vector<uint32_t> words = serialize(dfa, size);
+    fsa::BundleView view(words.data(), size);
+    CHECK(view.verify());
+    CHECK(view.engine() == fsa::Engine::DenseDFA);
+    CHECK(view.anchored() == anchored);
+    CHECK(view.size() == dfa.size());
+    CHECK(view.pattern_count() == patterns.size());
+    for(fsa::StateId s = 0; s < dfa.size(); s++){
+        for(int b = 0; b < 256; b++) CHECK(view.next(s, static_cast<uint8_t>(b)) == dfa.next(s, static_cast<uint8_t>(b)));
+    }
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(view.match_set(text) == dfa.match_set(text));
+        CHECK(view.accepts(text) == dfa.accepts(text));
+        CHECK(view.find(text) == dfa.find(text));
+    }
+}
+
+bool opens(const void* data, size_t size){
+    try{
+        fsa::BundleView view(data, size);
+    }catch(const std::runtime_error&){
+        return false;
+    }
+    return true;
+}
+
+void check_damage(){
+    fsa::DFA dfa = fsa::compile({"abc", "x+y"});
+    size_t size = 0;
+    std::vector<uint32_t> words = serialize(dfa, size);
+    CHECK(opens(words.data(), size));
+    CHECK(!opens(words.data(), size - 4));
+    CHECK(!opens(words.data(), sizeof(fsa::BundleHeader) - 1));
+
+    std::vector<uint32_t> bad_magic = words;
+    reinterpret_cast<char*>(bad_magic.data())[0] = 'X';
+    CHECK(!opens(bad_magic.data(), size));
+
+    // A transition past the last state opens, but fails verify().
+    std::vector<uint32_t> bad_state = words;
+    size_t table = (sizeof(fsa::BundleHeader) + 512) / 4;
+    bad_state[table] = static_cast<uint32_t>(dfa.size());
+    CHECK(!fsa::BundleView(bad_state.data(), size).verify());
+}
+
+void check_rules(){
+    std::istringstream in("# comment\nabc\r\n\n  x+\n#\nlast");
+    std::vector<size_t> lines;
+    std::vector<std::string> rules = fsa::read_rules(in, &lines);
+    CHECK(rules == (std::vector<std::string>{"abc", "  x+", "last"}));
+    CHECK(lines == (std::vector<size_t>{2, 4, 6}));
+}
+
+}
+
+int main(){
+    std::mt19937 rng(86);
+    for(int i = 0; i < 100; i++){
+        check_round_trip(rng, false);
+        check_round_trip(rng, true);
+    }
+    check_damage();
+    check_rules();
+    return fsa_test::finish("bundle_test");
+}
@@ -0,0 +1,31 @@
+#ifndef FSA_TESTS_CHECK_H
+#define FSA_TESTS_CHECK_H
+
+#include <iostream>
+
+// Minimal checks for the ctest targets: a failed CHECK prints its location
+// and makes the test exit non-zero, but the rest of the test still runs.
+
+namespace fsa_test {
+
+inline int& failures(){
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* what){
+    std::cerr << file << ":" << line << ": check failed: " << what << "\n";
+    failures()++;
+}
+
+inline int finish(const char* name){
+    if(failures()) std::cerr << name << ": " << failures() << " failed checks\n";
+    return failures() ? 1 : 0;
+}
+
+}
+
+#define CHECK(condition) \
+    do{ if(!(condition)) fsa_test::fail(__FILE__, __LINE__, #condition); }while(0)
+
+#endif
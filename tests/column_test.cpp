@@ -0,0 +1,89 @@
+// filter_column() over Arrow-style string columns, against matching each
+// row on its own.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "sql.h"
+
+namespace {
+
+// Rows in Arrow layout, with every third row null when `nulls` is set.
+template <class Offset>
+struct Column {
+    std::vector<Offset> offsets{0};
+    std::string data;
+    std::vector<uint8_t> validity;
+
+    Column(const std::vector<std::string>& rows, bool nulls) : validity((rows.size() + 7) / 8, 0){
+        for(size_t i = 0; i < rows.size(); i++){
+            bool valid = !nulls || i % 3 != 1;
+            if(valid){
+                data += rows[i];
+                validity[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+            }
+            offsets.push_back(static_cast<Offset>(data.size()));
+        }
+    }
+
+    fsa::StringColumn<Offset> view(bool nulls) const {
+        return {offsets.data(), reinterpret_cast<const uint8_t*>(data.data()), offsets.size() - 1,
+                nulls ? validity.data() : nullptr};
+    }
+};
+
+bool selected(const std::vector<uint8_t>& selection, size_t row){
+    return selection[row / 8] >> (row % 8) & 1;
+}
+
+template <class Offset>
+void check_filter(std::mt19937& rng, bool whole_value, bool nulls){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = whole_value;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    std::vector<std::string> rows(rng() % 40);
+    for(std::string& r : rows) r = fsa_test::random_input(rng);
+    Column<Offset> column(rows, nulls);
+    std::vector<bool> absorbing = fsa::absorbing_states(dfa);
+    fsa::ColumnFilter filter;
+    filter.whole_value = whole_value;
+    filter.absorbing = rng() % 2 ? &absorbing : nullptr;
+    std::vector<uint8_t> selection((rows.size() + 7) / 8, 0xff);
+    fsa::filter_column(dfa, column.view(nulls), selection.data(), filter);
+    for(size_t i = 0; i < rows.size(); i++){
+        bool expected = (!nulls || i % 3 != 1) && (whole_value ? dfa.accepts(rows[i]) : dfa.find(rows[i]));
+        CHECK(selected(selection, i) == expected);
+    }
+}
+
+void check_sql_filter(){
+    std::vector<std::string> rows = {"apple", "pineapple", "grape", "applesauce", "apple pie", "", "APPLE"};
+    Column<int64_t> column(rows, false);
+    fsa::SqlMatcher matcher(fsa::SqlSyntax::Like, "%apple%");
+    std::vector<uint8_t> selection(1);
+    matcher.filter(column.view(false), selection.data());
+    CHECK(selection[0] == 0x1b);
+    Column<int32_t> with_nulls(rows, true);
+    matcher.filter(with_nulls.view(true), selection.data());
+    CHECK(selection[0] == 0x09);     // rows 1 and 4 are null
+}
+
+}
+
+int main(){
+    std::mt19937 rng(95);
+    for(int i = 0; i < 200; i++){
+        for(bool whole_value : {false, true}){
+            check_filter<int32_t>(rng, whole_value, false);
+            check_filter<int64_t>(rng, whole_value, true);
+        }
+    }
+    check_sql_filter();
+    return fsa_test::finish("column_test");
+}
@@ -0,0 +1,67 @@
+// CombDFA against the DFA it was built from.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "comb.h"
+#include "compile.h"
+#include "random_patterns.h"
+
+namespace {
+
+void check_same_table(const fsa::DFA& dfa, const fsa::CombDFA& comb){
+    CHECK(comb.size() == dfa.size());
+    CHECK(comb.start() == dfa.start());
+    CHECK(comb.used_slots() <= comb.slots());
+    for(fsa::StateId s = 0; s < dfa.size(); s++){
+        for(int b = 0; b < 256; b++) CHECK(comb.next(s, static_cast<uint8_t>(b)) == dfa.next(s, static_cast<uint8_t>(b)));
+        CHECK(comb.accepting(s) == dfa.accepting(s));
+    }
+}
+
+void check_comb(std::mt19937& rng, bool anchored){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    fsa::CombDFA comb(dfa);
+    check_same_table(dfa, comb);
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(comb.match_set(text) == dfa.match_set(text));
+        CHECK(comb.accepts(text) == dfa.accepts(text));
+        CHECK(comb.find(text) == dfa.find(text));
+    }
+}
+
+// Enough distinct rows that placement has to search past occupied slots.
+void check_literals(std::mt19937& rng, size_t count){
+    std::vector<std::string> words(count);
+    for(std::string& w : words){
+        w.resize(4 + rng() % 6);
+        for(char& c : w) c = static_cast<char>('a' + rng() % 26);
+    }
+    fsa::CompileOptions options;
+    options.anchored = true;
+    fsa::DFA dfa = fsa::compile(words, options);
+    fsa::CombDFA comb(dfa);
+    check_same_table(dfa, comb);
+    CHECK(comb.memory_usage() < dfa.memory_usage());
+    for(size_t i = 0; i < words.size(); i++) CHECK(comb.accepts(words[i]));
+}
+
+}
+
+int main(){
+    std::mt19937 rng(79);
+    for(int i = 0; i < 150; i++){
+        check_comb(rng, false);
+        check_comb(rng, true);
+    }
+    check_literals(rng, 300);
+    // Thousands of rows, where first-fit has to skip long occupied runs.
+    check_literals(rng, 3000);
+    return fsa_test::finish("comb_test");
+}
@@ -0,0 +1,120 @@
+// The compile() pipeline and the state renumbering passes.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "layout.h"
+#include "random_patterns.h"
+
+namespace {
+
+bool is_order(const std::vector<fsa::StateId>& order, size_t size){
+    std::vector<fsa::StateId> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t i = 0; i < sorted.size(); i++){
+        if(sorted[i] != i) return false;
+    }
+    return sorted.size() == size;
+}
+
+// Minimized and unminimized automata, and every renumbering of them, agree.
+void check_layouts(std::mt19937& rng, bool anchored){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    options.minimize = false;
+    fsa::DFA plain = fsa::compile(patterns, options);
+    CHECK(dfa.size() <= plain.size());
+
+    // compile() already lays states out breadth-first from the start.
+    std::vector<fsa::StateId> bfs = fsa::bfs_order(dfa);
+    CHECK(is_order(bfs, dfa.size()));
+    CHECK(dfa.start() == 0);
+    bool identity = true;
+    for(size_t i = 0; i < bfs.size(); i++) identity &= bfs[i] == i;
+    CHECK(identity);
+
+    std::string sample;
+    for(int i = 0; i < 8; i++) sample += fsa_test::random_input(rng);
+    std::vector<uint64_t> weight = fsa::visit_counts(dfa, sample);
+    std::vector<fsa::StateId> hot = fsa::hot_order(dfa, weight);
+    CHECK(is_order(hot, dfa.size()));
+    for(size_t i = 1; i < hot.size(); i++) CHECK(weight[hot[i - 1]] >= weight[hot[i]] || weight[hot[i]] == 0);
+    fsa::DFA reordered = fsa::renumber(dfa, hot);
+    CHECK(reordered.size() == dfa.size());
+
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        std::vector<fsa::PatternId> expected = dfa.match_set(text);
+        CHECK(plain.match_set(text) == expected);
+        CHECK(reordered.match_set(text) == expected);
+        CHECK(reordered.accepts(text) == dfa.accepts(text));
+    }
+}
+
+// Known minimal sizes, and minimizing a minimal DFA again changes nothing.
+void check_minimal(std::mt19937& rng){
+    fsa::CompileOptions anchored;
+    anchored.anchored = true;
+    CHECK(fsa::compile("(a|b)*abb", anchored).size() == 4);
+    CHECK(fsa::compile("a*", anchored).size() == 1);
+    CHECK(fsa::compile("(ab|ac)d", anchored).size() == 4);
+    CHECK(fsa::compile("abc").size() == 4);
+    CHECK(fsa::compile({"ab", "ab"}).size() == 3);
+    for(int i = 0; i < 200; i++){
+        anchored.anchored = rng() % 2;
+        fsa::DFA dfa = fsa::compile(fsa_test::random_patterns(rng), anchored);
+        CHECK(fsa::minimize(dfa).size() == dfa.size());
+    }
+}
+
+// Unanchored sets of many literals, where every state carries the start
+// closure, against searching for each literal.
+void check_literal_sets(std::mt19937& rng){
+    std::vector<std::string> words(200);
+    for(std::string& w : words){
+        w.resize(2 + rng() % 5);
+        for(char& c : w) c = "abcd"[rng() % 4];
+    }
+    fsa::DFA dfa = fsa::compile(words);
+    for(int i = 0; i < 200; i++){
+        std::string text(rng() % 20, 'a');
+        for(char& c : text) c = "abcde"[rng() % 5];
+        std::vector<fsa::PatternId> expected;
+        for(size_t w = 0; w < words.size(); w++){
+            if(text.find(words[w]) != std::string::npos) expected.push_back(static_cast<fsa::PatternId>(w));
+        }
+        CHECK(dfa.match_set(text) == expected);
+    }
+}
+
+void check_visit_counts(){
+    fsa::CompileOptions options;
+    options.anchored = true;
+    fsa::DFA dfa = fsa::compile("ab*", options);
+    std::vector<uint64_t> weight = fsa::visit_counts(dfa, "abbb");
+    CHECK(weight[dfa.start()] == 1);
+    fsa::StateId after_a = dfa.next(dfa.start(), 'a');
+    CHECK(dfa.next(after_a, 'b') == after_a);
+    CHECK(weight[after_a] == 4);
+    CHECK(fsa::hot_order(dfa, weight).front() == after_a);
+}
+
+}
+
+int main(){
+    std::mt19937 rng(76);
+    for(int i = 0; i < 200; i++){
+        check_layouts(rng, false);
+        check_layouts(rng, true);
+    }
+    check_visit_counts();
+    check_minimal(rng);
+    check_literal_sets(rng);
+    return fsa_test::finish("compile_test");
+}
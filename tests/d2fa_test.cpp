@@ -0,0 +1,65 @@
+// D2FA against the DFA it was built from.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "d2fa.h"
+#include "random_patterns.h"
+
+namespace {
+
+// Default chains point to earlier states and stay within max_chain.
+unsigned chain_length(const fsa::D2FA& d2fa, fsa::StateId s){
+    unsigned length = 0;
+    for(fsa::StateId d = d2fa.default_of(s); d != fsa::D2FA::DEAD; d = d2fa.default_of(d)){
+        if(d >= s) return UINT32_MAX;
+        s = d;
+        length++;
+    }
+    return length;
+}
+
+void check_d2fa(std::mt19937& rng, bool anchored, const fsa::D2FAOptions& options){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions compile_options;
+    compile_options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, compile_options);
+    fsa::D2FA d2fa(dfa, options);
+    CHECK(d2fa.size() == dfa.size());
+    CHECK(d2fa.start() == dfa.start());
+    for(fsa::StateId s = 0; s < dfa.size(); s++){
+        CHECK(chain_length(d2fa, s) <= options.max_chain);
+        for(int b = 0; b < 256; b++) CHECK(d2fa.next(s, static_cast<uint8_t>(b)) == dfa.next(s, static_cast<uint8_t>(b)));
+        CHECK(d2fa.accepting(s) == dfa.accepting(s));
+    }
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(d2fa.match_set(text) == dfa.match_set(text));
+        CHECK(d2fa.accepts(text) == dfa.accepts(text));
+        CHECK(d2fa.find(text) == dfa.find(text));
+    }
+}
+
+}
+
+int main(){
+    std::mt19937 rng(80);
+    fsa::D2FAOptions short_chains;
+    short_chains.max_chain = 1;
+    short_chains.candidates = 4;
+    for(int i = 0; i < 100; i++){
+        for(bool anchored : {false, true}){
+            check_d2fa(rng, anchored, {});
+            check_d2fa(rng, anchored, short_chains);
+        }
+    }
+
+    // Unanchored union DFAs are mostly copies of the start row.
+    fsa::DFA dfa = fsa::compile({"alpha", "beta", "gamma", "delta", "epsilon"});
+    fsa::D2FA d2fa(dfa);
+    CHECK(d2fa.transition_count() < dfa.size() * dfa.byte_classes().count / 2);
+    return fsa_test::finish("d2fa_test");
+}
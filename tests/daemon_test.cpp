@@ -0,0 +1,159 @@
+// MatchServer and MatchClient over a Unix socket, against the DFA the
+// served bundle was written from.
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "compile.h"
+#include "daemon.h"
+
+namespace {
+
+std::string socket_path(){
+    return "/tmp/fsa-daemon-test-" + std::to_string(::getpid()) + ".sock";
+}
+
+// A raw connection, for requests MatchClient would never send.
+int connect_raw(const std::string& path){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The server drops the connection instead of answering.
+bool drops(int fd, const void* request, size_t size){
+    if(::send(fd, request, size, MSG_NOSIGNAL) != static_cast<ssize_t>(size)) return true;
+    char reply;
+    return ::recv(fd, &reply, 1, 0) == 0;
+}
+
+// Sends one SHARED item of `length` bytes backed by `memfd`, the way
+// MatchClient does, and returns the error message the server answers
+// with, or "" for any other reply.
+std::string shared_error(int fd, int memfd, uint64_t length){
+    struct {
+        uint32_t header[2];
+        fsa::wire::Item item;
+    } request = {{fsa::wire::REQUEST_MAGIC, 1}, {fsa::wire::SHARED, 0, length}};
+    iovec iov{&request, sizeof(request)};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(c), &memfd, sizeof(int));
+    if(::sendmsg(fd, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request))) return "";
+    uint32_t reply[2];
+    if(::recv(fd, reply, sizeof(reply), MSG_WAITALL) != sizeof(reply) || reply[0] != fsa::wire::ERROR_MAGIC) return "";
+    std::string message(reply[1], '\0');
+    if(::recv(fd, message.data(), message.size(), MSG_WAITALL) != static_cast<ssize_t>(message.size())) return "";
+    return message;
+}
+
+}
+
+int main(){
+    std::vector<std::string> patterns = {"needle", "[0-9]{4}", "x.*y"};
+    fsa::DFA dfa = fsa::compile(patterns);
+    std::ostringstream out;
+    fsa::write_bundle(dfa, out);
+    std::string bytes = out.str();
+    std::vector<uint32_t> words((bytes.size() + 3) / 4);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    fsa::BundleView bundle(words.data(), bytes.size());
+
+    std::string path = socket_path();
+    fsa::MatchServer server(bundle, path);
+    std::thread serving([&]{ server.serve(); });
+
+    std::vector<std::string> texts = {"", "a needle here", "1234", "x and y", "none", std::string(5000, 'x') + "y",
+                                      std::string(300, 'n') + "needle 2024"};
+    for(size_t threshold : {size_t{1} << 20, size_t{64}, size_t{0}}){
+        fsa::MatchClient client(path, threshold);
+        std::vector<std::string_view> buffers(texts.begin(), texts.end());
+        std::vector<std::vector<fsa::PatternId>> results = client.match(buffers);
+        CHECK(results.size() == texts.size());
+        for(size_t i = 0; i < texts.size() && i < results.size(); i++) CHECK(results[i] == dfa.match_set(texts[i]));
+    }
+
+    // More buffers than one request may carry, with more than MAX_SHARED
+    // of them shared.
+    {
+        fsa::MatchClient client(path, 8);
+        std::vector<std::string> many(fsa::wire::MAX_BATCH + 10);
+        for(size_t i = 0; i < many.size(); i++) many[i] = i % 3 ? "short" : "long enough needle";
+        std::vector<std::string_view> buffers(many.begin(), many.end());
+        std::vector<std::vector<fsa::PatternId>> results = client.match(buffers);
+        bool same = results.size() == many.size();
+        for(size_t i = 0; same && i < many.size(); i++) same = results[i] == dfa.match_set(many[i]);
+        CHECK(same);
+    }
+
+    uint32_t bad_magic[2] = {0x12345678, 1};
+    int fd = connect_raw(path);
+    CHECK(fd >= 0 && drops(fd, bad_magic, sizeof(bad_magic)));
+    ::close(fd);
+    // A SHARED item without a descriptor.
+    struct {
+        uint32_t header[2];
+        fsa::wire::Item item;
+    } missing_fd = {{fsa::wire::REQUEST_MAGIC, 1}, {fsa::wire::SHARED, 0, 10}};
+    fd = connect_raw(path);
+    CHECK(fd >= 0 && drops(fd, &missing_fd, sizeof(missing_fd)));
+    ::close(fd);
+
+    // An unsealed memfd could shrink under the server's mapping, and a
+    // sealed one shorter than its item would fault past its end; both get
+    // an error reply, and the connection still answers afterwards.
+    fd = connect_raw(path);
+    CHECK(fd >= 0);
+    int unsealed = ::memfd_create("unsealed", MFD_CLOEXEC);
+    CHECK(::write(unsealed, "a needle!!", 10) == 10);
+    CHECK(shared_error(fd, unsealed, 10).find("not sealed") != std::string::npos);
+    int truncated = ::memfd_create("truncated", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    CHECK(::write(truncated, "need", 4) == 4);
+    CHECK(::fcntl(truncated, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) == 0);
+    CHECK(shared_error(fd, truncated, 1 << 20).find("shorter") != std::string::npos);
+    struct {
+        uint32_t header[2];
+        fsa::wire::Item item;
+    } inline_request = {{fsa::wire::REQUEST_MAGIC, 1}, {fsa::wire::INLINE, 0, 6}};
+    uint32_t expected[4] = {fsa::wire::RESPONSE_MAGIC, 1, 1, 0};
+    uint32_t reply[4] = {};
+    CHECK(::send(fd, &inline_request, sizeof(inline_request), MSG_NOSIGNAL) == sizeof(inline_request));
+    CHECK(::send(fd, "needle", 6, MSG_NOSIGNAL) == 6);
+    CHECK(::recv(fd, reply, sizeof(reply), MSG_WAITALL) == sizeof(reply) && std::memcmp(reply, expected, sizeof(reply)) == 0);
+    ::close(unsealed);
+    ::close(truncated);
+    ::close(fd);
+
+    // The server keeps serving other clients.
+    fsa::MatchClient client(path);
+    CHECK(client.match({"needle"}) == std::vector<std::vector<fsa::PatternId>>{{0}});
+
+    server.stop();
+    serving.join();
+    return fsa_test::finish("daemon_test");
+}
@@ -0,0 +1,115 @@
+// DecompressedReader on gzip, zstd and plain files.
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "compile.h"
+#include "decompress.h"
+
+namespace {
+
+// 500 x "alpha line\n" + "needle 1\n", and 100 x "second member needle\n".
+const std::string GZIP_FIRST(
+    "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff\xed\xc6\xb1\x09\x00\x20\x0c\x00\xb0\xdd\x2b\x7c\xc1\x93"
+    "\x0a\x16\x14\x8a\xf8\xff\xe4\x13\x8e\xc9\x94\xa8\xbb\xa2\xd7\x3e\xd9\x42\x55\x55\x55\x55\x55\x55"
+    "\x55\x55\x55\x55\xff\xf4\x64\xce\xca\x3e\xda\x03\x8e\xda\x7d\x97\x85\x15\x00\x00", 68);
+const std::string GZIP_SECOND(
+    "\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff\x2b\x4e\x4d\xce\xcf\x4b\x51\xc8\x4d\xcd\x4d\x4a\x2d\x52"
+    "\xc8\x4b\x4d\x4d\xc9\x49\xe5\x2a\x1e\x15\x1c\x15\x1c\x15\x1c\x15\x1c\x15\x1c\x15\x1c\x15\x1c\x15"
+    "\x44\x15\x04\x00\x24\x46\x85\xd4\x34\x08\x00\x00", 60);
+// 100 x "zstd frame needle\n".
+const std::string ZSTD_FRAME(
+    "\x28\xb5\x2f\xfd\x00\x68\xd5\x00\x00\x90\x7a\x73\x74\x64\x20\x66\x72\x61\x6d\x65\x20\x6e\x65\x65"
+    "\x64\x6c\x65\x0a\x01\x00\xe6\xad\x7f\x86\x01", 35);
+
+std::string repeat(const std::string& s, int n){
+    std::string result;
+    for(int i = 0; i < n; i++) result += s;
+    return result;
+}
+
+std::string write_file(const std::string& name, const std::string& contents){
+    std::string path = "/tmp/fsa-decompress-test-" + std::to_string(::getpid()) + "-" + name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+std::string read_all(const std::string& path, size_t chunk_size){
+    fsa::DecompressOptions options;
+    options.chunk_size = chunk_size;
+    options.queue_depth = 2;
+    fsa::DecompressedReader reader(path, options);
+    std::string result;
+    for(std::string_view chunk = reader.next(); !chunk.empty(); chunk = reader.next()) result += chunk;
+    return result;
+}
+
+bool read_fails(const std::string& path){
+    try{
+        read_all(path, 1 << 16);
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+void check_gzip(){
+    std::string first = repeat("alpha line\n", 500) + "needle 1\n";
+    std::string second = repeat("second member needle\n", 100);
+    std::string one = write_file("one.gz", GZIP_FIRST);
+    std::string two = write_file("two.gz", GZIP_FIRST + GZIP_SECOND);
+    std::string cut = write_file("cut.gz", GZIP_FIRST.substr(0, 40));
+    // Zero padding after the last member, as tar and some writers leave.
+    std::string padded = write_file("padded.gz", GZIP_FIRST + GZIP_SECOND + std::string(1000, '\0'));
+    // One stray byte, too short to be the magic of another member.
+    std::string stray = write_file("stray.gz", GZIP_FIRST + std::string(1, '\x1f'));
+    CHECK(fsa::detect_compression(GZIP_FIRST) == fsa::Compression::Gzip);
+    if(fsa::compression_supported(fsa::Compression::Gzip)){
+        CHECK(read_all(one, 1 << 16) == first);
+        CHECK(read_all(one, 4096) == first);
+        CHECK(read_all(two, 4096) == first + second);
+        CHECK(read_fails(cut));
+        CHECK(read_all(padded, 4096) == first + second);
+        CHECK(read_all(padded, 1 << 16) == first + second);
+        CHECK(read_all(stray, 4096) == first);
+        fsa::DFA dfa = fsa::compile({"needle [0-9]", "member", "absent"});
+        CHECK(fsa::scan_compressed_file(dfa, two) == (std::vector<fsa::PatternId>{0, 1}));
+    }else{
+        CHECK(read_fails(one));
+    }
+    for(const std::string& p : {one, two, cut, padded, stray}) std::remove(p.c_str());
+}
+
+void check_zstd(){
+    std::string path = write_file("frame.zst", ZSTD_FRAME + ZSTD_FRAME);
+    CHECK(fsa::detect_compression(ZSTD_FRAME) == fsa::Compression::Zstd);
+    if(fsa::compression_supported(fsa::Compression::Zstd)){
+        CHECK(read_all(path, 4096) == repeat("zstd frame needle\n", 200));
+    }else{
+        CHECK(read_fails(path));
+    }
+    std::remove(path.c_str());
+}
+
+void check_plain(){
+    std::string text = repeat("plain text, no magic\n", 300);
+    std::string path = write_file("plain.txt", text);
+    CHECK(fsa::detect_compression(text) == fsa::Compression::None);
+    CHECK(read_all(path, 4096) == text);
+    std::remove(path.c_str());
+}
+
+}
+
+int main(){
+    check_gzip();
+    check_zstd();
+    check_plain();
+    return fsa_test::finish("decompress_test");
+}
@@ -0,0 +1,81 @@
+// detect_encoding() on hand-picked blocks, and against a byte-at-a-time
+// classifier on random ones.
+
+#include <random>
+#include <string>
+
+#include "check.h"
+#include "encoding.h"
+
+namespace {
+
+using fsa::Encoding;
+
+// Byte-at-a-time reference, with the same rule for a cut-off sequence.
+Encoding reference(std::string_view block){
+    bool multibyte = false;
+    bool valid = true;
+    for(size_t i = 0; i < block.size();){
+        unsigned char c = static_cast<unsigned char>(block[i]);
+        if(c == 0) return Encoding::Binary;
+        if(c < 0x80){
+            i++;
+            continue;
+        }
+        size_t length = 0;
+        unsigned min = 0;
+        if(c >= 0xc2 && c <= 0xdf){ length = 2; min = 0x80; }
+        else if(c >= 0xe0 && c <= 0xef){ length = 3; min = 0x800; }
+        else if(c >= 0xf0 && c <= 0xf4){ length = 4; min = 0x10000; }
+        unsigned code = length == 2 ? c & 0x1f : length == 3 ? c & 0x0f : c & 0x07;
+        size_t j = 1;
+        for(; length && j < length && i + j < block.size(); j++){
+            unsigned char d = static_cast<unsigned char>(block[i + j]);
+            if((d & 0xc0) != 0x80) break;
+            code = code << 6 | (d & 0x3f);
+        }
+        bool cut = length && i + j == block.size() && j < length;
+        if(!cut && (!length || j < length || code < min || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff))){
+            valid = false;
+        }
+        // A cut sequence can only be checked as far as it goes.
+        if(cut && length >= 3 && j >= 2){
+            unsigned char d = static_cast<unsigned char>(block[i + 1]);
+            if((c == 0xe0 && d < 0xa0) || (c == 0xed && d > 0x9f) || (c == 0xf0 && d < 0x90) || (c == 0xf4 && d > 0x8f)){
+                valid = false;
+            }
+        }
+        multibyte = true;
+        i += j;
+    }
+    if(!valid) return Encoding::Bytes;
+    return multibyte ? Encoding::Utf8 : Encoding::Ascii;
+}
+
+}
+
+int main(){
+    CHECK(fsa::detect_encoding("") == Encoding::Ascii);
+    CHECK(fsa::detect_encoding("plain ascii text\n") == Encoding::Ascii);
+    CHECK(fsa::detect_encoding("caf\xc3\xa9") == Encoding::Utf8);
+    CHECK(fsa::detect_encoding("\xe2\x82\xac and \xf0\x9f\x98\x80") == Encoding::Utf8);
+    CHECK(fsa::detect_encoding("caf\xe9 au lait") == Encoding::Bytes);
+    CHECK(fsa::detect_encoding("\xc0\xaf") == Encoding::Bytes);           // overlong
+    CHECK(fsa::detect_encoding("\xed\xa0\x80") == Encoding::Bytes);       // surrogate
+    CHECK(fsa::detect_encoding(std::string("text\0more", 9)) == Encoding::Binary);
+    CHECK(fsa::detect_encoding(std::string("caf\xe9 and then \0", 15)) == Encoding::Binary);
+    CHECK(fsa::detect_encoding("ends mid-sequence \xe2\x82") == Encoding::Utf8);
+
+    std::mt19937 rng(91);
+    const unsigned char BYTES[] = {'a', ' ', '\n', 0x80, 0x9f, 0xa0, 0xbf, 0xc2, 0xc3, 0xe0, 0xed, 0xef, 0xf0, 0xf4, 0xf5, 0xff};
+    int mismatches = 0;
+    for(int i = 0; i < 20000; i++){
+        std::string block(rng() % 24, 'a');
+        for(char& c : block){
+            if(rng() % 3 == 0) c = static_cast<char>(BYTES[rng() % sizeof(BYTES)]);
+        }
+        mismatches += fsa::detect_encoding(block) != reference(block);
+    }
+    CHECK(mismatches == 0);
+    return fsa_test::finish("encoding_test");
+}
@@ -0,0 +1,85 @@
+// FMIndex against brute force over small corpora.
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "fm_index.h"
+#include "random_patterns.h"
+
+namespace {
+
+using Spans = std::vector<std::pair<size_t, size_t>>;
+
+std::vector<size_t> positions(const std::string& text, const std::string& pattern){
+    std::vector<size_t> found;
+    for(size_t i = 0; i + pattern.size() <= text.size(); i++){
+        if(text.compare(i, pattern.size(), pattern) == 0) found.push_back(i);
+    }
+    return found;
+}
+
+Spans spans(const std::vector<fsa::FMMatch>& matches){
+    Spans result;
+    for(const fsa::FMMatch& m : matches) result.emplace_back(m.position, m.length);
+    return result;
+}
+
+void check_banana(){
+    for(uint32_t rate : {1u, 2u, 32u}){
+        fsa::FMIndexOptions options;
+        options.sample_rate = rate;
+        fsa::FMIndex index("banana", options);
+        CHECK(index.size() == 6);
+        CHECK(index.count("a") == 3);
+        CHECK(index.count("ana") == 2);
+        CHECK(index.count("x") == 0);
+        CHECK(index.count("") == 7);
+        CHECK(index.locate("ana") == (std::vector<size_t>{1, 3}));
+        CHECK(index.locate("a", 2).size() == 2);
+        CHECK(index.locate("banana") == std::vector<size_t>{0});
+        CHECK(spans(index.search("na+")) == (Spans{{2, 2}, {4, 2}}));
+        CHECK(index.search("b.n").size() == 1);
+        CHECK(index.search("q").empty());
+    }
+}
+
+void check_corpus(std::mt19937& rng){
+    std::string text(1 + rng() % 60, 'a');
+    for(char& c : text) c = "abcx1\n\0"[rng() % 7];
+    fsa::FMIndexOptions options;
+    options.sample_rate = 1 + rng() % 8;
+    fsa::FMIndex index(text, options);
+    for(int i = 0; i < 20; i++){
+        std::string pattern = text.substr(rng() % text.size(), 1 + rng() % 4);
+        if(rng() % 4 == 0) pattern += 'b';
+        std::vector<size_t> expected = positions(text, pattern);
+        CHECK(index.count(pattern) == expected.size());
+        CHECK(index.locate(pattern) == expected);
+    }
+
+    // Every non-empty substring the regex matches, by position and length.
+    std::string pattern = fsa_test::random_pattern(rng);
+    fsa::CompileOptions anchored;
+    anchored.anchored = true;
+    fsa::DFA dfa = fsa::compile(pattern, anchored);
+    Spans expected;
+    for(size_t i = 0; i < text.size(); i++){
+        for(size_t n = 1; i + n <= text.size(); n++){
+            if(dfa.accepts(std::string_view(text).substr(i, n))) expected.emplace_back(i, n);
+        }
+    }
+    CHECK(spans(index.search(pattern, SIZE_MAX)) == expected);
+}
+
+}
+
+int main(){
+    check_banana();
+    std::mt19937 rng(98);
+    for(int i = 0; i < 300; i++) check_corpus(rng);
+    return fsa_test::finish("fm_index_test");
+}
@@ -0,0 +1,74 @@
+// Brace alternation in globs, and GlobSet against testing globs one by one.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "glob.h"
+#include "walk.h"
+
+namespace {
+
+bool glob_matches(const std::string& glob, const std::string& path, const fsa::GlobOptions& glob_options = {}){
+    fsa::NFA nfa;
+    nfa.add(fsa::parse_glob(glob, glob_options));
+    fsa::CompileOptions options;
+    options.anchored = true;
+    return fsa::compile(nfa, options).accepts(path);
+}
+
+void check_braces(){
+    CHECK(glob_matches("*.{c,h}", "x.h"));
+    CHECK(!glob_matches("*.{c,h}", "x.cc"));
+    CHECK(glob_matches("{src,lib/{a,b}}/*.rs", "lib/b/m.rs"));
+    CHECK(!glob_matches("{src,lib/{a,b}}/*.rs", "lib/c/m.rs"));
+    CHECK(glob_matches("{a,}x", "x"));
+    CHECK(glob_matches("{**/,}test_*.py", "a/b/test_x.py"));
+    CHECK(glob_matches("\\{a,b\\}", "{a,b}"));
+    fsa::GlobOptions literal;
+    literal.braces = false;
+    CHECK(glob_matches("{a,b}", "{a,b}", literal));
+    CHECK(!glob_matches("{a,b}", "a", literal));
+    // .gitignore rules take braces literally.
+    CHECK(fsa::IgnoreRules({"{a,b}.txt"}).check("a.txt", false) == fsa::IgnoreRules::Verdict::None);
+    bool rejected = false;
+    try{
+        fsa::parse_glob("{a,b");
+    }catch(const fsa::ParseError&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+void check_glob_set(const fsa::GlobSetOptions& options){
+    std::vector<std::string> globs = {"*.c", "**/*.h", "docs/**", "Makefile", "src/{a,b}/*", "**/test_*", "?", "*"};
+    fsa::GlobSet set(globs, options);
+    CHECK(set.size() == globs.size());
+    std::mt19937 rng(93);
+    const char* parts[] = {"a", "b", "src", "docs", "x.c", "y.h", "test_1", "Makefile", "/"};
+    for(int i = 0; i < 2000; i++){
+        std::string path;
+        for(size_t n = rng() % 5; n > 0; n--) path += parts[rng() % 9];
+        std::vector<fsa::PatternId> expected;
+        for(size_t g = 0; g < globs.size(); g++){
+            if(glob_matches(globs[g], path)) expected.push_back(static_cast<fsa::PatternId>(g));
+        }
+        CHECK(set.matches(path) == expected);
+        CHECK(set.is_match(path) == !expected.empty());
+    }
+}
+
+}
+
+int main(){
+    check_braces();
+    check_glob_set({});
+    // Small enough that the set splits into several groups.
+    fsa::GlobSetOptions small;
+    small.max_group_states = 12;
+    CHECK(fsa::GlobSet({"*.c", "**/*.h", "docs/**", "Makefile", "src/{a,b}/*"}, small).group_count() > 1);
+    check_glob_set(small);
+    return fsa_test::finish("glob_test");
+}
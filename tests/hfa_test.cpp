@@ -0,0 +1,64 @@
+// HFA against the union DFA of the same patterns.
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "hfa.h"
+#include "random_patterns.h"
+
+namespace {
+
+void check_hfa(std::mt19937& rng){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::DFA dfa = fsa::compile(patterns);
+    fsa::HFA hfa(patterns);
+    CHECK(hfa.pattern_count() == patterns.size());
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(hfa.match_set(text) == dfa.match_set(text));
+    }
+}
+
+void check_split(){
+    fsa::Regex head, tail;
+    CHECK(fsa::split_at_wide_repeat(fsa::parse("ab.*cd"), head, tail));
+    CHECK(!fsa::split_at_wide_repeat(fsa::parse("abcd"), head, tail));
+    CHECK(!fsa::split_at_wide_repeat(fsa::parse("a[bc]*d"), head, tail));
+}
+
+// A.*B rules multiply each other's states in a union DFA but not here.
+void check_dot_star_rules(){
+    std::vector<std::string> patterns;
+    for(const char* word : {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"}){
+        patterns.push_back(std::string(word) + ".*" + word + "!");
+    }
+    fsa::HFA hfa(patterns);
+    CHECK(hfa.tail_count() == patterns.size());
+    CHECK(hfa.head().size() < 100);
+    CHECK(hfa.match_set("xx alpha yy golf zz alpha! golf!") == (std::vector<fsa::PatternId>{0, 6}));
+    CHECK(hfa.match_set("alpha! alpha").empty());
+
+    fsa::CompileOptions anchored;
+    anchored.anchored = true;
+    bool rejected = false;
+    try{
+        fsa::HFA(patterns, anchored);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+}
+
+int main(){
+    std::mt19937 rng(81);
+    for(int i = 0; i < 300; i++) check_hfa(rng);
+    check_split();
+    check_dot_star_rules();
+    return fsa_test::finish("hfa_test");
+}
@@ -0,0 +1,56 @@
+// HybridDFA against the DFA it was built from.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "hybrid.h"
+#include "random_patterns.h"
+
+namespace {
+
+void check_hybrid(std::mt19937& rng, bool anchored, const fsa::HybridOptions& options){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions compile_options;
+    compile_options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, compile_options);
+    fsa::HybridDFA hybrid(dfa, options);
+    CHECK(hybrid.size() == dfa.size());
+    CHECK(hybrid.start() == dfa.start());
+    for(fsa::StateId s = 0; s < dfa.size(); s++){
+        for(int b = 0; b < 256; b++) CHECK(hybrid.next(s, static_cast<uint8_t>(b)) == dfa.next(s, static_cast<uint8_t>(b)));
+        CHECK(hybrid.accepting(s) == dfa.accepting(s));
+    }
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(hybrid.match_set(text) == dfa.match_set(text));
+        CHECK(hybrid.accepts(text) == dfa.accepts(text));
+        CHECK(hybrid.find(text) == dfa.find(text));
+    }
+}
+
+}
+
+int main(){
+    std::mt19937 rng(78);
+    fsa::HybridOptions all_sparse;
+    all_sparse.max_sparse_ranges = 256;
+    fsa::HybridOptions all_dense;
+    all_dense.max_sparse_ranges = 0;
+    for(int i = 0; i < 100; i++){
+        for(bool anchored : {false, true}){
+            check_hybrid(rng, anchored, {});
+            check_hybrid(rng, anchored, all_sparse);
+            check_hybrid(rng, anchored, all_dense);
+        }
+    }
+
+    fsa::DFA dfa = fsa::compile({"abc", "[a-z]+z", "q"});
+    CHECK(fsa::HybridDFA(dfa, all_sparse).dense_count() == 0);
+    CHECK(fsa::HybridDFA(dfa, all_dense).dense_count() == dfa.size());
+    all_sparse.dense_states = {dfa.start()};
+    CHECK(fsa::HybridDFA(dfa, all_sparse).dense_count() == 1);
+    return fsa_test::finish("hybrid_test");
+}
@@ -0,0 +1,63 @@
+// scan_lines() against matching each line on its own.
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "lines.h"
+#include "random_patterns.h"
+
+namespace {
+
+using Spans = std::vector<std::pair<size_t, size_t>>;
+
+// Lines of `text` that do (or, inverted, do not) contain a match.
+Spans expected_lines(const fsa::DFA& dfa, std::string_view text, bool invert){
+    Spans spans;
+    for(size_t begin = 0; begin < text.size();){
+        size_t end = text.find('\n', begin);
+        if(end == std::string_view::npos) end = text.size();
+        if(dfa.find(text.substr(begin, end - begin)) != invert) spans.emplace_back(begin, end);
+        begin = end + 1;
+    }
+    return spans;
+}
+
+void check_lines(std::mt19937& rng, bool anchored){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng) + fsa_test::random_input(rng) + fsa_test::random_input(rng);
+        Spans found, missing;
+        size_t n = fsa::scan_lines(dfa, text, [&](size_t b, size_t e){ found.emplace_back(b, e); });
+        size_t m = fsa::scan_lines_inverted(dfa, text, [&](size_t b, size_t e){ missing.emplace_back(b, e); });
+        CHECK(found == expected_lines(dfa, text, false));
+        CHECK(missing == expected_lines(dfa, text, true));
+        CHECK(n == found.size());
+        CHECK(m == missing.size());
+        CHECK(n + m == fsa::count_lines(text));
+    }
+}
+
+}
+
+int main(){
+    std::mt19937 rng(90);
+    for(int i = 0; i < 200; i++){
+        check_lines(rng, false);
+        check_lines(rng, true);
+    }
+    CHECK(fsa::count_lines("") == 0);
+    CHECK(fsa::count_lines("a") == 1);
+    CHECK(fsa::count_lines("a\n") == 1);
+    CHECK(fsa::count_lines("\n\nb") == 3);
+    // A match may not span the newline between two lines.
+    fsa::DFA dfa = fsa::compile("ab");
+    CHECK(fsa::scan_lines(dfa, "xa\nbx\nab", [](size_t, size_t){}) == 1);
+    return fsa_test::finish("lines_test");
+}
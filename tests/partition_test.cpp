@@ -0,0 +1,71 @@
+// Partitioned rule sets against one DFA of the whole set.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "partition.h"
+#include "random_patterns.h"
+
+namespace {
+
+// Every pattern lands in exactly one group, and each group fits the budget.
+void check_groups(const fsa::Partition& partition, size_t patterns, size_t budget){
+    std::vector<int> seen(patterns, 0);
+    CHECK(partition.groups.size() == partition.dfas.size());
+    for(size_t k = 0; k < partition.groups.size(); k++){
+        CHECK(partition.dfas[k].size() <= budget);
+        CHECK(partition.dfas[k].pattern_count() == partition.groups[k].size());
+        for(fsa::PatternId p : partition.groups[k]) seen[p]++;
+    }
+    CHECK(std::all_of(seen.begin(), seen.end(), [](int n){ return n == 1; }));
+}
+
+void check_partition(std::mt19937& rng){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::DFA dfa = fsa::compile(patterns);
+    fsa::PartitionOptions options;
+    options.max_group_states = 64;
+    fsa::Partition partition = fsa::partition_patterns(patterns, options);
+    CHECK(partition.pattern_count == patterns.size());
+    check_groups(partition, patterns.size(), options.max_group_states);
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(partition.match_set(text) == dfa.match_set(text));
+    }
+}
+
+// A.*B rules blow up together, so a tight budget needs several groups.
+void check_budget(){
+    std::vector<std::string> patterns;
+    for(const char* word : {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot"}){
+        patterns.push_back(std::string(word) + ".*" + word + "!");
+    }
+    fsa::PartitionOptions options;
+    options.max_group_states = 200;
+    fsa::Partition partition = fsa::partition_patterns(patterns, options);
+    CHECK(partition.groups.size() > 1);
+    check_groups(partition, patterns.size(), options.max_group_states);
+    CHECK(partition.match_set("echo alpha echo! alpha!") == (std::vector<fsa::PatternId>{0, 4}));
+
+    options.max_group_states = 3;
+    bool rejected = false;
+    try{
+        fsa::partition_patterns(patterns, options);
+    }catch(const fsa::StateLimitError&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+}
+
+int main(){
+    std::mt19937 rng(82);
+    for(int i = 0; i < 200; i++) check_partition(rng);
+    check_budget();
+    return fsa_test::finish("partition_test");
+}
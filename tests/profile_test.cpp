@@ -0,0 +1,145 @@
+// Transition-count profiles and profile-guided compilation.
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "profile.h"
+
+namespace {
+
+const std::vector<std::string> PATTERNS = {"GET /[a-z]+", "POST /api/[0-9]+", "x{3}y"};
+const char* SAMPLE = "GET /index GET /home GET /abc POST /api/7 xxxy GET /a";
+
+void check_training(){
+    fsa::DFA dfa = fsa::compile(PATTERNS);
+    fsa::Profile profile(dfa);
+    CHECK(profile.fits(dfa));
+    profile.train(dfa, SAMPLE);
+    CHECK(profile.visits(dfa.start()) > 0);
+    CHECK(profile.transitions(dfa.start(), 'G') > 0);
+    CHECK(profile.transitions(dfa.start(), 'Q') == 0);
+    CHECK(profile.total() == std::string(SAMPLE).size() + 1);
+
+    std::vector<fsa::StateId> hot = profile.hot_states(1.0);
+    uint64_t covered = 0;
+    for(size_t i = 0; i < hot.size(); i++){
+        covered += profile.visits(hot[i]);
+        if(i > 0) CHECK(profile.visits(hot[i - 1]) >= profile.visits(hot[i]));
+    }
+    CHECK(covered == profile.total());
+    CHECK(profile.hot_states(0.5).size() <= hot.size());
+    CHECK(profile.hot_states(0.5).front() == hot.front());
+
+    fsa::DFA other = fsa::compile("GET /[a-z]*");
+    CHECK(!profile.fits(other));
+    bool rejected = false;
+    try{
+        profile.train(other, SAMPLE);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+void check_save_load(){
+    fsa::DFA dfa = fsa::compile(PATTERNS);
+    fsa::Profile profile(dfa);
+    profile.train(dfa, SAMPLE);
+    std::stringstream text;
+    profile.save(text);
+    fsa::Profile loaded = fsa::Profile::load(text);
+    CHECK(loaded.fits(dfa));
+    CHECK(loaded.state_weights() == profile.state_weights());
+    for(fsa::StateId s = 0; s < dfa.size(); s++){
+        for(int b = 0; b < 256; b++) CHECK(loaded.transitions(s, static_cast<uint8_t>(b)) == profile.transitions(s, static_cast<uint8_t>(b)));
+    }
+
+    for(const char* bad : {"", "fsa-profile 2\n", "fsa-profile 1\nstates 2 fingerprint 0\nv 5 1\n",
+                           "fsa-profile 1\nstates 2 fingerprint 0\nt 0 256 1\n"}){
+        std::istringstream in(bad);
+        bool rejected = false;
+        try{
+            fsa::Profile::load(in);
+        }catch(const std::runtime_error&){
+            rejected = true;
+        }
+        CHECK(rejected);
+    }
+
+    // A huge state count is refused before anything is allocated for it.
+    std::istringstream huge("fsa-profile 1\nstates 99999999999999 fingerprint 0\n");
+    bool rejected = false;
+    try{
+        fsa::Profile::load(huge);
+    }catch(const std::runtime_error&){
+        rejected = true;
+    }
+    CHECK(rejected);
+    std::istringstream again(text.str());
+    CHECK(fsa::Profile::load(again, dfa.size()).fits(dfa));
+    again.str(text.str());
+    again.clear();
+    rejected = false;
+    try{
+        fsa::Profile::load(again, dfa.size() - 1);
+    }catch(const std::runtime_error&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+// Compiling with a profile puts the hottest state first and keeps the
+// language; a stale profile is ignored.
+void check_guided_compile(){
+    fsa::DFA dfa = fsa::compile(PATTERNS);
+    fsa::Profile profile(dfa);
+    profile.train(dfa, SAMPLE);
+    fsa::CompileOptions options;
+    options.profile = &profile;
+    fsa::DFA guided = fsa::compile(PATTERNS, options);
+    CHECK(guided.size() == dfa.size());
+    CHECK(profile.hot_states(1.0).size() > 1);
+    fsa::Profile replay(guided);
+    replay.train(guided, SAMPLE);
+    CHECK(replay.visits(0) == profile.visits(profile.hot_states(1.0).front()));
+    for(const char* text : {"GET /x", "POST /api/12", "POST /api/", "xxy", "axxxyb", ""}){
+        CHECK(guided.match_set(text) == dfa.match_set(text));
+    }
+
+    // Hot states asked for on the reordered DFA are its heavily visited
+    // ones, not the profiled DFA's ids reused.
+    std::vector<fsa::StateId> hot = profile.hot_states(guided, 0.9);
+    std::vector<fsa::StateId> profiled_hot = profile.hot_states(0.9);
+    CHECK(profile.hot_states(dfa, 0.9) == profiled_hot);
+    CHECK(hot.size() == profiled_hot.size() && hot != profiled_hot);
+    uint64_t covered = 0;
+    for(size_t i = 0; i < hot.size() && i < profiled_hot.size(); i++){
+        CHECK(replay.visits(hot[i]) == profile.visits(profiled_hot[i]));
+        covered += replay.visits(hot[i]);
+    }
+    CHECK(covered >= 0.9 * replay.total());
+    bool rejected = false;
+    try{
+        profile.hot_states(fsa::compile("GET /[a-z]*"), 0.9);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    fsa::DFA stale = fsa::compile({"GET /[a-z]+", "POST /api/[0-9]+"}, options);
+    fsa::CompileOptions plain;
+    CHECK(fsa::fingerprint(stale) == fsa::fingerprint(fsa::compile({"GET /[a-z]+", "POST /api/[0-9]+"}, plain)));
+}
+
+}
+
+int main(){
+    check_training();
+    check_save_load();
+    check_guided_compile();
+    return fsa_test::finish("profile_test");
+}
@@ -0,0 +1,86 @@
+// Published<T>: versions stay alive while a reader holds them, and are
+// reclaimed once no reader can see them.
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "publish.h"
+
+namespace {
+
+std::atomic<int> live{0};
+
+// A version whose two halves must always agree when read.
+struct Version {
+    explicit Version(int n) : a(n), b(n){ live++; }
+    ~Version(){ live--; }
+    int a;
+    int b;
+};
+
+void check_reclaim(){
+    {
+        fsa::Published<Version> published(std::make_unique<Version>(0), 2);
+        fsa::Published<Version>::Reader reader = published.reader();
+        {
+            auto held = reader.lock();
+            published.publish(std::make_unique<Version>(1));
+            // The reader still holds version 0.
+            CHECK(held->a == 0);
+            CHECK(published.reclaim() == 1);
+            CHECK(live == 2);
+        }
+        CHECK(published.reclaim() == 0);
+        CHECK(live == 1);
+        CHECK(reader.lock()->a == 1);
+
+        fsa::Published<Version>::Reader second = published.reader();
+        bool exhausted = false;
+        try{
+            published.reader();
+        }catch(const std::runtime_error&){
+            exhausted = true;
+        }
+        CHECK(exhausted);
+    }
+    CHECK(live == 0);
+}
+
+void check_concurrent(){
+    {
+        fsa::Published<Version> published(std::make_unique<Version>(0));
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+        std::vector<std::thread> readers;
+        for(int t = 0; t < 4; t++){
+            readers.emplace_back([&]{
+                auto reader = published.reader();
+                int last = 0;
+                while(!done){
+                    auto version = reader.lock();
+                    if(version->a != version->b || version->a < last) torn++;
+                    last = version->a;
+                }
+            });
+        }
+        for(int n = 1; n <= 2000; n++) published.publish(std::make_unique<Version>(n));
+        done = true;
+        for(std::thread& t : readers) t.join();
+        CHECK(torn == 0);
+        CHECK(published.reclaim() == 0);
+        CHECK(live == 1);
+    }
+    CHECK(live == 0);
+}
+
+}
+
+int main(){
+    check_reclaim();
+    check_concurrent();
+    return fsa_test::finish("publish_test");
+}
@@ -0,0 +1,37 @@
+#ifndef FSA_TESTS_RANDOM_PATTERNS_H
+#define FSA_TESTS_RANDOM_PATTERNS_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Small random pattern sets and inputs over a few bytes, so that matches,
+// overlaps and dead ends all come up often.
+
+namespace fsa_test {
+
+inline const char* const ATOMS[] = {"a", "b", "c", "[ab]", ".", "\\n", "(a|bc)", "b?", "c+", "x{2}",
+                                    ".*", "[^\\n]*", "[abc]*", "(ab)+", "\\d"};
+
+inline std::string random_pattern(std::mt19937& rng){
+    std::string pattern;
+    size_t atoms = 1 + rng() % 6;
+    for(size_t i = 0; i < atoms; i++) pattern += ATOMS[rng() % (sizeof(ATOMS) / sizeof(ATOMS[0]))];
+    return pattern;
+}
+
+inline std::vector<std::string> random_patterns(std::mt19937& rng){
+    std::vector<std::string> patterns(1 + rng() % 4);
+    for(std::string& p : patterns) p = random_pattern(rng);
+    return patterns;
+}
+
+inline std::string random_input(std::mt19937& rng){
+    std::string text(rng() % 16, ' ');
+    for(char& c : text) c = "abcx1\n"[rng() % 6];
+    return text;
+}
+
+}
+
+#endif
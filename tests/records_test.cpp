@@ -0,0 +1,46 @@
+// filter_records() over packed fixed-width records, against matching each
+// record on its own.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+
+namespace {
+
+void check_records(std::mt19937& rng, bool whole_value){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = whole_value || rng() % 2;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    size_t record_size = rng() % 9;
+    size_t records = rng() % 30;
+    std::string data(record_size * records, ' ');
+    for(char& c : data) c = "abcx1\n"[rng() % 6];
+    std::vector<bool> absorbing = fsa::absorbing_states(dfa);
+    fsa::ColumnFilter filter;
+    filter.whole_value = whole_value;
+    filter.absorbing = rng() % 2 ? &absorbing : nullptr;
+    std::vector<uint8_t> selection((records + 7) / 8, 0xff);
+    fsa::filter_records(dfa, reinterpret_cast<const uint8_t*>(data.data()), record_size, records, selection.data(), filter);
+    for(size_t i = 0; i < records; i++){
+        std::string_view record = std::string_view(data).substr(i * record_size, record_size);
+        bool expected = whole_value ? dfa.accepts(record) : dfa.find(record);
+        CHECK((selection[i / 8] >> (i % 8) & 1) == expected);
+    }
+}
+
+}
+
+int main(){
+    std::mt19937 rng(99);
+    for(int i = 0; i < 500; i++){
+        check_records(rng, false);
+        check_records(rng, true);
+    }
+    return fsa_test::finish("records_test");
+}
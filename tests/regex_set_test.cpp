@@ -0,0 +1,85 @@
+// RegexSet against DFAs compiled from scratch, across adds and removes.
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "regex_set.h"
+
+namespace {
+
+void check_static(std::mt19937& rng){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::DFA dfa = fsa::compile(patterns);
+    fsa::RegexSet set(patterns);
+    CHECK(set.size() == patterns.size());
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(set.match_set(text) == dfa.match_set(text));
+        CHECK(set.find(text) == dfa.find(text));
+    }
+}
+
+// Each step adds or removes a pattern; the cache must then agree with a
+// DFA compiled from the live patterns, mapped to their public ids.
+void check_updates(std::mt19937& rng, const fsa::RegexSetOptions& options){
+    fsa::RegexSet set(options);
+    std::vector<std::string> live;
+    std::vector<fsa::PatternId> ids;
+    for(int step = 0; step < 30; step++){
+        if(live.empty() || rng() % 3){
+            std::string p = fsa_test::random_pattern(rng);
+            live.push_back(p);
+            ids.push_back(set.add(p));
+        }else{
+            size_t k = rng() % live.size();
+            set.remove(ids[k]);
+            CHECK(!set.contains(ids[k]));
+            live.erase(live.begin() + static_cast<long>(k));
+            ids.erase(ids.begin() + static_cast<long>(k));
+        }
+        CHECK(set.size() == live.size());
+        fsa::DFA dfa = fsa::compile(live);
+        for(int i = 0; i < 5; i++){
+            std::string text = fsa_test::random_input(rng);
+            std::vector<fsa::PatternId> expected;
+            for(fsa::PatternId local : dfa.match_set(text)) expected.push_back(ids[local]);
+            CHECK(set.match_set(text) == expected);
+        }
+    }
+}
+
+void check_ids(){
+    fsa::RegexSet set({"abc", "b+"});
+    CHECK(set.match_set("xabcx") == (std::vector<fsa::PatternId>{0, 1}));
+    set.remove(1);
+    CHECK(set.match_set("xabcx") == std::vector<fsa::PatternId>{0});
+    CHECK(set.add("x") == 2);
+    CHECK(set.match_set("xabcx") == (std::vector<fsa::PatternId>{0, 2}));
+    bool rejected = false;
+    try{
+        set.remove(1);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+}
+
+int main(){
+    std::mt19937 rng(84);
+    for(int i = 0; i < 200; i++) check_static(rng);
+    fsa::RegexSetOptions tiny_cache;
+    tiny_cache.max_cached_states = 4;
+    for(int i = 0; i < 10; i++){
+        check_updates(rng, {});
+        check_updates(rng, tiny_cache);
+    }
+    check_ids();
+    return fsa_test::finish("regex_set_test");
+}
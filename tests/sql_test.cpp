@@ -0,0 +1,116 @@
+// LIKE and SIMILAR TO, and the batch loops they evaluate columns with.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "batch.h"
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "sql.h"
+
+namespace {
+
+bool like(const char* pattern, std::string_view value, const fsa::SqlPatternOptions& options = {}){
+    return fsa::SqlMatcher(fsa::SqlSyntax::Like, pattern, options).matches(value);
+}
+
+bool similar(const char* pattern, std::string_view value){
+    return fsa::SqlMatcher(fsa::SqlSyntax::SimilarTo, pattern).matches(value);
+}
+
+bool rejects(fsa::SqlSyntax syntax, const char* pattern){
+    try{
+        fsa::SqlMatcher(syntax, pattern);
+    }catch(const fsa::ParseError&){
+        return true;
+    }
+    return false;
+}
+
+void check_like(){
+    CHECK(like("a%b", "ab"));
+    CHECK(like("a%b", "axxxb"));
+    CHECK(!like("a%b", "axxxbc"));
+    CHECK(like("%a%b%c%", "xxaxxbxxcxx"));
+    CHECK(!like("%a%b%c%", "cba"));
+    CHECK(like("a_c", "abc"));
+    CHECK(!like("a_c", "ac"));
+    CHECK(like("a_c", "a\xc3\xa9" "c"));       // '_' is one UTF-8 character
+    CHECK(like("10\\%", "10%"));
+    CHECK(!like("10\\%", "100"));
+    CHECK(like("a.*", "a.*"));                  // regex characters are literal
+    CHECK(!like("a.*", "ab"));
+    CHECK(like("a%", "a\xff"));
+    fsa::SqlPatternOptions ilike;
+    ilike.case_insensitive = true;
+    CHECK(like("ab%", "ABC", ilike));
+    CHECK(!like("ab%", "ABC"));
+    fsa::SqlPatternOptions bytes;
+    bytes.utf8 = false;
+    CHECK(!like("a_c", "a\xc3\xa9" "c", bytes));
+    fsa::SqlPatternOptions bang;
+    bang.escape = '!';
+    CHECK(like("5!%", "5%", bang));
+    CHECK(like("a\\b", "a\\b", bang));
+    CHECK(rejects(fsa::SqlSyntax::Like, "abc\\"));
+}
+
+void check_similar(){
+    CHECK(similar("(ab|cd)+", "abcdab"));
+    CHECK(!similar("(ab|cd)+", "abc"));
+    CHECK(similar("a.c", "a.c"));               // '.' is literal
+    CHECK(!similar("a.c", "abc"));
+    CHECK(similar("%(x|y)%", "zzyzz"));
+    CHECK(similar("[0-9]{3}-%", "123-abc"));
+    CHECK(!similar("[0-9]{3}-%", "12-abc"));
+    CHECK(similar("a_b", "a\xc3\xa9" "b"));
+    CHECK(similar("a*", ""));
+    CHECK(similar("(a|b)?c", "c"));
+    CHECK(similar("x\\%", "x%"));
+    // '%' takes any bytes, as in LIKE, valid UTF-8 or not.
+    CHECK(similar("a%b", "a\xff\xfe" "b"));
+    CHECK(similar("%", "\xc3"));
+    CHECK(like("%", "\xc3"));
+    CHECK(rejects(fsa::SqlSyntax::SimilarTo, "(ab"));
+}
+
+// The batch loops agree with accepts() and find() on every input, with and
+// without absorbing states.
+void check_batches(std::mt19937& rng){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = rng() % 2;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    std::vector<bool> absorbing = fsa::absorbing_states(dfa);
+    std::vector<std::string> texts(rng() % 12);
+    for(std::string& t : texts) t = fsa_test::random_input(rng);
+    std::vector<std::string_view> inputs(texts.begin(), texts.end());
+    std::vector<uint8_t> accepted(inputs.size()), found(inputs.size()), quick(inputs.size());
+    fsa::accepts_batch(dfa, inputs.data(), inputs.size(), accepted.data());
+    fsa::find_batch(dfa, inputs.data(), inputs.size(), found.data());
+    fsa::accepts_batch(dfa, inputs.data(), inputs.size(), quick.data(), &absorbing);
+    for(size_t i = 0; i < inputs.size(); i++){
+        CHECK(accepted[i] == dfa.accepts(inputs[i]));
+        CHECK(quick[i] == dfa.accepts(inputs[i]));
+        CHECK(found[i] == dfa.find(inputs[i]));
+    }
+}
+
+void check_evaluate(){
+    fsa::SqlMatcher matcher(fsa::SqlSyntax::Like, "%needle%");
+    std::vector<std::string_view> values = {"", "needle", "a needle in", "needl", "hay", "xxneedle", "NEEDLE"};
+    CHECK(matcher.evaluate(values) == (std::vector<uint8_t>{0, 1, 1, 0, 0, 1, 0}));
+}
+
+}
+
+int main(){
+    check_like();
+    check_similar();
+    std::mt19937 rng(94);
+    for(int i = 0; i < 300; i++) check_batches(rng);
+    check_evaluate();
+    return fsa_test::finish("sql_test");
+}
@@ -0,0 +1,97 @@
+// SuffixAutomaton against brute force over the substrings of small corpora.
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "suffix_automaton.h"
+
+namespace {
+
+fsa::DFA anchored(const std::string& pattern){
+    fsa::CompileOptions options;
+    options.anchored = true;
+    return fsa::compile(pattern, options);
+}
+
+size_t occurrences(const std::string& text, const std::string& pattern){
+    size_t n = 0;
+    for(size_t i = 0; i + pattern.size() <= text.size(); i++) n += text.compare(i, pattern.size(), pattern) == 0;
+    return n;
+}
+
+void check_banana(){
+    fsa::SuffixAutomaton sam("banana");
+    CHECK(sam.contains("nan"));
+    CHECK(!sam.contains("nab"));
+    CHECK(sam.count("a") == 3);
+    CHECK(sam.count("ana") == 2);
+    CHECK(sam.count("banana") == 1);
+    CHECK(sam.count("bananas") == 0);
+    CHECK(sam.intersects(anchored("n[a-z]n")));
+    CHECK(!sam.intersects(anchored("nn")));
+    std::vector<fsa::SubstringMatch> found = sam.matches(anchored("an+a?"));
+    CHECK(found.size() == 2);
+    if(found.size() == 2){
+        CHECK(found[0].text == "an" && found[0].count == 2);
+        CHECK(found[1].text == "ana" && found[1].count == 2);
+    }
+}
+
+void check_corpus(std::mt19937& rng){
+    std::string text(1 + rng() % 40, 'a');
+    for(char& c : text) c = "abc\n"[rng() % 4];
+    fsa::SuffixAutomaton sam(text);
+    CHECK(sam.size() <= 2 * text.size() + 1);
+
+    std::map<std::string, size_t> substrings;
+    for(size_t i = 0; i < text.size(); i++){
+        for(size_t n = 1; i + n <= text.size(); n++) substrings[text.substr(i, n)]++;
+    }
+    for(const auto& [s, n] : substrings) CHECK(sam.count(s) == n);
+    for(const char* absent : {"d", "abcabcabcabcabcabcabcabcabcabcabcabcabca"}){
+        CHECK(sam.count(absent) == occurrences(text, absent));
+    }
+
+    std::string pattern = fsa_test::random_pattern(rng);
+    fsa::DFA dfa = anchored(pattern);
+    std::vector<fsa::SubstringMatch> expected;
+    for(const auto& [s, n] : substrings){
+        if(dfa.accepts(s)) expected.push_back({s, n});
+    }
+    std::vector<fsa::SubstringMatch> found = sam.matches(dfa, SIZE_MAX);
+    bool same = found.size() == expected.size();
+    for(size_t i = 0; same && i < found.size(); i++){
+        same = found[i].text == expected[i].text && found[i].count == expected[i].count;
+    }
+    CHECK(same);
+    CHECK(sam.intersects(dfa) == !expected.empty());
+}
+
+// A corpus large enough that states are cloned and edges re-pointed many
+// times while building.
+void check_large(std::mt19937& rng){
+    std::string text(200000, 'a');
+    for(char& c : text) c = static_cast<char>("abcd"[rng() % 4] + (rng() % 50 == 0 ? 100 : 0));
+    fsa::SuffixAutomaton sam(text);
+    CHECK(sam.size() <= 2 * text.size() + 1);
+    for(int i = 0; i < 200; i++){
+        std::string pattern = text.substr(rng() % text.size(), 1 + rng() % 12);
+        if(rng() % 3 == 0) pattern[rng() % pattern.size()] = 'e';
+        CHECK(sam.count(pattern) == occurrences(text, pattern));
+    }
+}
+
+}
+
+int main(){
+    check_banana();
+    std::mt19937 rng(97);
+    for(int i = 0; i < 300; i++) check_corpus(rng);
+    check_large(rng);
+    return fsa_test::finish("suffix_automaton_test");
+}
@@ -0,0 +1,66 @@
+// Trigram query extraction and the posting-list index.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "trigram.h"
+
+namespace {
+
+void check_queries(){
+    CHECK(fsa::trigram_query("abcd").to_string() == "\"abc\" \"bcd\"");
+    CHECK(fsa::trigram_query("(abc|xyz)q").to_string() == "(\"abc\" \"bcq\") | (\"xyz\" \"yzq\")");
+    CHECK(fsa::trigram_query("[ab]cde").to_string() == "(\"acd\" \"cde\") | (\"bcd\" \"cde\")");
+    CHECK(fsa::trigram_query("hello.*world").to_string() == "\"ell\" \"hel\" \"llo\" \"orl\" \"rld\" \"wor\"");
+    CHECK(fsa::trigram_query("ab").to_string() == "+");
+    CHECK(fsa::trigram_query("abc|x").to_string() == "+");
+}
+
+void check_index(){
+    fsa::TrigramIndex index;
+    CHECK(index.add("the quick brown fox") == 0);
+    CHECK(index.add("jumps over the lazy dog") == 1);
+    CHECK(index.add("hello world") == 2);
+    CHECK(index.size() == 3);
+    CHECK(index.candidates(fsa::trigram_query("quick|lazy")) == (std::vector<uint32_t>{0, 1}));
+    CHECK(index.candidates(fsa::trigram_query("the")) == (std::vector<uint32_t>{0, 1}));
+    CHECK(index.candidates(fsa::trigram_query("hel+o.*world")) == std::vector<uint32_t>{2});
+    CHECK(index.candidates(fsa::trigram_query("zebra")).empty());
+    CHECK(index.candidates(fsa::trigram_query("x?")) == (std::vector<uint32_t>{0, 1, 2}));
+}
+
+// The prefilter may keep documents that do not match, never drop one that does.
+void check_sound(std::mt19937& rng){
+    const char* words[] = {"abc", "bca", "cab", "abca", "[ab]c", "(ab|bc)c", "a+bc", "c{2}a"};
+    std::string pattern;
+    for(size_t n = 1 + rng() % 3; n > 0; n--){
+        pattern += words[rng() % 8];
+        if(rng() % 3 == 0) pattern += fsa_test::ATOMS[rng() % 15];
+    }
+    fsa::DFA dfa = fsa::compile(pattern);
+    fsa::TrigramIndex index;
+    std::vector<std::string> documents(30);
+    for(std::string& d : documents){
+        d = fsa_test::random_input(rng) + "abcab" + fsa_test::random_input(rng);
+        index.add(d);
+    }
+    std::vector<uint32_t> candidates = index.candidates(fsa::trigram_query(pattern));
+    for(uint32_t i = 0; i < documents.size(); i++){
+        if(dfa.find(documents[i])) CHECK(std::binary_search(candidates.begin(), candidates.end(), i));
+    }
+}
+
+}
+
+int main(){
+    check_queries();
+    check_index();
+    std::mt19937 rng(96);
+    for(int i = 0; i < 300; i++) check_sound(rng);
+    return fsa_test::finish("trigram_test");
+}
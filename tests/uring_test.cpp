@@ -0,0 +1,89 @@
+// StreamMatcher over chunked input, and io_uring file scans against the
+// bundle's match_set() on the whole file.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "stream.h"
+#include "uring_scan.h"
+
+namespace {
+
+void check_stream(std::mt19937& rng, bool anchored){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::CompileOptions options;
+    options.anchored = anchored;
+    fsa::DFA dfa = fsa::compile(patterns, options);
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng) + fsa_test::random_input(rng);
+        fsa::StreamMatcher<fsa::DFA> stream(dfa);
+        for(size_t at = 0; at < text.size();){
+            size_t n = std::min<size_t>(1 + rng() % 5, text.size() - at);
+            stream.feed(std::string_view(text).substr(at, n));
+            at += n;
+        }
+        CHECK(stream.matches() == dfa.match_set(text));
+    }
+}
+
+void check_uring(){
+    fsa::DFA dfa = fsa::compile({"needle", "[0-9]{6}", "^head"});
+    std::ostringstream out;
+    fsa::write_bundle(dfa, out);
+    std::string bytes = out.str();
+    std::vector<uint32_t> words((bytes.size() + 3) / 4);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    fsa::BundleView bundle(words.data(), bytes.size());
+
+    std::string dir = "/tmp/fsa-uring-test-" + std::to_string(::getpid());
+    std::vector<std::string> contents = {"", "head and needle", std::string(100000, 'a') + "needle",
+                                         std::string(70000, '1'), "nothing here"};
+    std::vector<std::string> paths;
+    for(size_t i = 0; i < contents.size(); i++){
+        paths.push_back(dir + "-" + std::to_string(i));
+        std::ofstream(paths.back(), std::ios::binary) << contents[i];
+    }
+    paths.push_back(dir + "-missing");
+
+    fsa::UringScanOptions options;
+    options.chunk_size = 4096;
+    options.buffers = 4;
+    options.workers = 2;
+    try{
+        std::vector<fsa::FileMatches> results = fsa::scan_files_uring(bundle, paths, options);
+        CHECK(results.size() == paths.size());
+        for(size_t i = 0; i < contents.size() && i < results.size(); i++){
+            CHECK(results[i].error == 0);
+            CHECK(results[i].matches == bundle.match_set(contents[i]));
+        }
+        CHECK(results.size() == paths.size() && results.back().error == ENOENT);
+    }catch(const std::system_error& e){
+        std::cerr << "uring_test: io_uring unavailable, file scan skipped: " << e.what() << "\n";
+    }
+    for(const std::string& p : paths) std::remove(p.c_str());
+}
+
+}
+
+int main(){
+    std::mt19937 rng(88);
+    for(int i = 0; i < 100; i++){
+        check_stream(rng, false);
+        check_stream(rng, true);
+    }
+    check_uring();
+    return fsa_test::finish("uring_test");
+}
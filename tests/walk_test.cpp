@@ -0,0 +1,126 @@
+// Globs, .gitignore rules and the parallel directory walk.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "compile.h"
+#include "glob.h"
+#include "walk.h"
+
+namespace {
+
+using Verdict = fsa::IgnoreRules::Verdict;
+
+bool glob_matches(const char* glob, const char* path){
+    fsa::NFA nfa;
+    nfa.add(fsa::parse_glob(glob));
+    fsa::CompileOptions options;
+    options.anchored = true;
+    return fsa::compile(nfa, options).accepts(path);
+}
+
+void check_globs(){
+    CHECK(glob_matches("*.c", "main.c"));
+    CHECK(!glob_matches("*.c", "src/main.c"));
+    CHECK(!glob_matches("*.c", "main.cc"));
+    CHECK(glob_matches("src/?.h", "src/a.h"));
+    CHECK(!glob_matches("src/?.h", "src/ab.h"));
+    CHECK(!glob_matches("?", "/"));
+    CHECK(glob_matches("**/x", "x"));
+    CHECK(glob_matches("**/x", "a/b/x"));
+    CHECK(glob_matches("a/**", "a/b/c"));
+    CHECK(!glob_matches("a/**", "ab/c"));
+    CHECK(glob_matches("a/**/b", "a/b"));
+    CHECK(glob_matches("a/**/b", "a/x/y/b"));
+    CHECK(glob_matches("a**b", "axxb"));
+    CHECK(!glob_matches("a**b", "ax/xb"));
+    CHECK(glob_matches("[!a]*", "bcd"));
+    CHECK(!glob_matches("[!a]*", "abc"));
+    CHECK(glob_matches("[a-c]x", "bx"));
+    CHECK(!glob_matches("[a-z]", "/"));
+    CHECK(glob_matches("\\*", "*"));
+    CHECK(!glob_matches("\\*", "a"));
+    bool rejected = false;
+    try{
+        fsa::parse_glob("[abc");
+    }catch(const fsa::ParseError&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+void check_rules(){
+    fsa::IgnoreRules rules({"# comment", "*.o", "build/", "/top.txt", "docs/*.md", "!keep.o", "", "[unclosed"});
+    CHECK(rules.check("a.o", false) == Verdict::Ignore);
+    CHECK(rules.check("src/deep/a.o", false) == Verdict::Ignore);
+    CHECK(rules.check("keep.o", false) == Verdict::Keep);
+    CHECK(rules.check("build", true) == Verdict::Ignore);
+    CHECK(rules.check("build", false) == Verdict::None);
+    CHECK(rules.check("src/build", true) == Verdict::Ignore);
+    CHECK(rules.check("top.txt", false) == Verdict::Ignore);
+    CHECK(rules.check("sub/top.txt", false) == Verdict::None);
+    CHECK(rules.check("docs/a.md", false) == Verdict::Ignore);
+    CHECK(rules.check("x/docs/a.md", false) == Verdict::None);
+    CHECK(rules.check("main.c", false) == Verdict::None);
+    CHECK(fsa::IgnoreRules().empty());
+}
+
+void write(const std::string& path, const std::string& text){
+    std::ofstream(path) << text;
+}
+
+void check_walk(){
+    std::string root = "/tmp/fsa-walk-test-" + std::to_string(::getpid());
+    for(const char* dir : {"", "/src", "/src/gen", "/build", "/.git", "/docs"}){
+        ::mkdir((root + dir).c_str(), 0755);
+    }
+    write(root + "/.gitignore", "build/\n*.log\n");
+    write(root + "/a.txt", "");
+    write(root + "/run.log", "");
+    write(root + "/build/out.bin", "");
+    write(root + "/.git/HEAD", "");
+    write(root + "/src/main.c", "");
+    write(root + "/src/.gitignore", "gen/*\n!gen/keep.c\n!*.log\n");
+    write(root + "/src/gen/drop.c", "");
+    write(root + "/src/gen/keep.c", "");
+    write(root + "/src/debug.log", "");
+    write(root + "/docs/notes.md", "");
+    CHECK(::symlink("a.txt", (root + "/link.txt").c_str()) == 0);
+
+    std::vector<std::string> errors;
+    fsa::WalkOptions options;
+    options.threads = 3;
+    std::vector<std::string> files = fsa::walk_files({root, root + "/missing"}, options, &errors);
+    std::vector<std::string> expected;
+    for(const char* f : {"/.gitignore", "/a.txt", "/docs/notes.md", "/src/.gitignore", "/src/debug.log",
+                         "/src/gen/keep.c", "/src/main.c"}){
+        expected.push_back(root + f);
+    }
+    CHECK(files == expected);
+    CHECK(errors.size() == 1);
+
+    options.ignore = {"docs/"};
+    options.ignore_files = false;
+    files = fsa::walk_files({root}, options);
+    CHECK(files.size() == 9);
+    CHECK(fsa::walk_files({root + "/a.txt"}) == std::vector<std::string>{root + "/a.txt"});
+
+    std::string command = "rm -rf " + root;
+    CHECK(std::system(command.c_str()) == 0);
+}
+
+}
+
+int main(){
+    check_globs();
+    check_rules();
+    check_walk();
+    return fsa_test::finish("walk_test");
+}
@@ -0,0 +1,87 @@
+// XFA against the union DFA of the same patterns.
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "compile.h"
+#include "random_patterns.h"
+#include "xfa.h"
+
+namespace {
+
+void check_xfa(std::mt19937& rng){
+    std::vector<std::string> patterns = fsa_test::random_patterns(rng);
+    fsa::DFA dfa = fsa::compile(patterns);
+    fsa::XFA xfa(patterns);
+    CHECK(xfa.pattern_count() == patterns.size());
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng);
+        CHECK(xfa.match_set(text) == dfa.match_set(text));
+    }
+}
+
+// Chains of segments joined by `.*`, some of them without a fixed length,
+// so that cuts are made, refused and undone.
+void check_cuts(std::mt19937& rng){
+    const char* segments[] = {"a", "b", "c+", "ab", "b?c", "[ab]c", "x{2}", "a*b"};
+    std::vector<std::string> patterns(1 + rng() % 3);
+    for(std::string& p : patterns){
+        p = segments[rng() % 8];
+        for(size_t n = 1 + rng() % 3; n > 0; n--) p += std::string(".*") + segments[rng() % 8];
+    }
+    fsa::DFA dfa = fsa::compile(patterns);
+    fsa::XFA xfa(patterns);
+    for(int i = 0; i < 20; i++){
+        std::string text = fsa_test::random_input(rng) + fsa_test::random_input(rng);
+        CHECK(xfa.match_set(text) == dfa.match_set(text));
+    }
+}
+
+// Ordered segments share one small DFA; the order lives in variables.
+void check_segments(){
+    fsa::XFA xfa({"ab.*cd.*ef", "cd.*ab", "xyz"});
+    CHECK(xfa.variable_count() == 3);
+    CHECK(xfa.match_set("ab cd ef") == std::vector<fsa::PatternId>{0});
+    CHECK(xfa.match_set("ef cd ab") == std::vector<fsa::PatternId>{1});
+    CHECK(xfa.match_set("cd ab cd ef xyz") == (std::vector<fsa::PatternId>{0, 1, 2}));
+    CHECK(xfa.match_set("abcdef") == std::vector<fsa::PatternId>{0});
+    CHECK(xfa.match_set("abcd").empty());
+    // The gap of `.*` is broken by a newline.
+    CHECK(xfa.match_set("ab\ncd ef").empty());
+    CHECK(xfa.match_set("ab\nab cd ef") == std::vector<fsa::PatternId>{0});
+    // Segments may not overlap.
+    CHECK(xfa.match_set("cdab").size() == 1);
+    CHECK(fsa::XFA({"aba.*aba"}).match_set("ababa").empty());
+
+    // A cut that cannot be tested exactly must not break earlier cuts:
+    // merging c+ back into b.*c+ leaves b without a fixed length, so the
+    // a.*b cut has to be undone as well.
+    fsa::XFA merged({"a.*b.*c+"});
+    CHECK(merged.match_set("abc") == std::vector<fsa::PatternId>{0});
+    CHECK(merged.match_set("xaxbxccx") == std::vector<fsa::PatternId>{0});
+    CHECK(merged.match_set("acb").empty());
+    CHECK(fsa::XFA({"ab.*c.*d+e"}).match_set("abcdde") == std::vector<fsa::PatternId>{0});
+
+    fsa::CompileOptions anchored;
+    anchored.anchored = true;
+    bool rejected = false;
+    try{
+        fsa::XFA({"a.*b"}, anchored);
+    }catch(const std::invalid_argument&){
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+}
+
+int main(){
+    std::mt19937 rng(83);
+    for(int i = 0; i < 300; i++) check_xfa(rng);
+    for(int i = 0; i < 300; i++) check_cuts(rng);
+    check_segments();
+    return fsa_test::finish("xfa_test");
+}